@@ -1,8 +1,8 @@
 /* THIS FILE WILL BE OVERWRITTEN BY DEV-C++ */
 /* DO NOT EDIT ! */
 
-#ifndef MS-BASIC_PRIVATE_H
-#define MS-BASIC_PRIVATE_H
+#ifndef MS_BASIC_PRIVATE_H
+#define MS_BASIC_PRIVATE_H
 
 /* VERSION DEFINITIONS */
 #define VER_STRING	"0.1.0.34"
@@ -20,4 +20,4 @@
 #define PRODUCT_NAME	"MS-Basic"
 #define PRODUCT_VERSION	"0.1.0.34"
 
-#endif /*MS-BASIC_PRIVATE_H*/
+#endif /*MS_BASIC_PRIVATE_H*/
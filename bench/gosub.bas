@@ -0,0 +1,12 @@
+10 REM GOSUB recursion: each call goes 100 levels deep, the depth is a global counter
+20 M = 0
+30 FOR R = 1 TO 500
+40 D = 0 : GOSUB 100
+50 NEXT R
+60 PRINT "MAX DEPTH"; M
+70 END
+100 D = D + 1
+110 IF D > M THEN M = D
+120 IF D < 100 THEN GOSUB 100
+130 D = D - 1
+140 RETURN
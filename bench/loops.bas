@@ -0,0 +1,9 @@
+10 REM Nested FOR loops with integer and floating point arithmetic
+20 S = 0 : T% = 0
+30 FOR I% = 1 TO 100
+40 FOR J% = 1 TO 100
+50 FOR K% = 1 TO 20
+60 S = S + I% * J% / K%
+70 T% = (T% + K%) MOD 1000
+80 NEXT K%, J%, I%
+90 PRINT S, T%
@@ -0,0 +1,29 @@
+10 REM Menu dispatch: a wide ON GOSUB table, every entry used in turn
+20 T = 0
+30 FOR R = 1 TO 5000
+40 FOR K = 1 TO 20
+50 ON K GOSUB 1000, 1010, 1020, 1030, 1040, 1050, 1060, 1070, 1080, 1090, 1100, 1110, 1120, 1130, 1140, 1150, 1160, 1170, 1180, 1190
+60 NEXT K
+70 NEXT R
+80 PRINT "TOTAL"; T
+90 END
+1000 T = T + 1 : RETURN
+1010 T = T + 2 : RETURN
+1020 T = T + 3 : RETURN
+1030 T = T + 4 : RETURN
+1040 T = T + 5 : RETURN
+1050 T = T + 6 : RETURN
+1060 T = T + 7 : RETURN
+1070 T = T + 8 : RETURN
+1080 T = T + 9 : RETURN
+1090 T = T + 10 : RETURN
+1100 T = T + 11 : RETURN
+1110 T = T + 12 : RETURN
+1120 T = T + 13 : RETURN
+1130 T = T + 14 : RETURN
+1140 T = T + 15 : RETURN
+1150 T = T + 16 : RETURN
+1160 T = T + 17 : RETURN
+1170 T = T + 18 : RETURN
+1180 T = T + 19 : RETURN
+1190 T = T + 20 : RETURN
@@ -0,0 +1,5 @@
+10 REM PRINT heavy output: zones, separators, TAB and numbers
+20 FOR I = 1 TO 20000
+30 PRINT I, I * I, SQR(I); TAB(50); "LINE"
+40 PRINT "A"; I; "B", -I / 7
+50 NEXT I
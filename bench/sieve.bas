@@ -0,0 +1,12 @@
+10 REM Sieve of Eratosthenes, primes below 8190, repeated 10 times
+20 DIM F%(8190)
+30 FOR R% = 1 TO 10
+40 C = 0
+50 FOR I = 0 TO 8190 : F%(I) = 1 : NEXT I
+60 FOR I = 2 TO 8190
+70 IF F%(I) = 0 THEN 110
+80 C = C + 1
+90 FOR K = I + I TO 8190 STEP I : F%(K) = 0 : NEXT K
+110 NEXT I
+120 NEXT R%
+130 PRINT C; "PRIMES"
@@ -0,0 +1,21 @@
+10 REM Array sorts: bubble sort then insertion sort of pseudo random numbers
+20 N = 300 : DIM A(300), B(300)
+30 RANDOMIZE 42
+40 FOR I = 1 TO N : A(I) = INT(RND * 10000) : B(I) = A(I) : NEXT I
+50 REM Bubble sort
+60 FOR I = 1 TO N - 1
+70 FOR J = 1 TO N - I
+80 IF A(J) > A(J + 1) THEN T = A(J) : A(J) = A(J + 1) : A(J + 1) = T
+90 NEXT J, I
+100 REM Insertion sort
+110 FOR I = 2 TO N
+120 T = B(I) : J = I - 1
+130 IF J < 1 THEN 160
+140 IF B(J) <= T THEN 160
+150 B(J + 1) = B(J) : J = J - 1 : GOTO 130
+160 B(J + 1) = T
+170 NEXT I
+180 FOR I = 1 TO N
+190 IF A(I) <> B(I) THEN PRINT "MISMATCH AT"; I : END
+200 NEXT I
+210 PRINT "SORTED"; A(1); A(N)
@@ -0,0 +1,10 @@
+10 REM String concatenation churn
+20 FOR R = 1 TO 2000
+30 A$ = ""
+40 FOR I = 1 TO 100
+50 A$ = A$ + CHR$(65 + I MOD 26)
+60 IF LEN(A$) > 50 THEN A$ = MID$(A$, 10) + LEFT$(A$, 5)
+70 NEXT I
+80 B$ = RIGHT$(A$, 10) + STR$(R) + STRING$(3, "*")
+90 NEXT R
+100 PRINT A$ : PRINT B$
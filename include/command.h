@@ -28,40 +28,95 @@
 
 // #include "tokenizer.h"
 #include "tokens.h"
+#include "errors.h"
+#include "statements.h"
+#include "program.h"
+
+#include <memory>
+#include <set>
+
+class Runtime;
 
 /**
  * A command is only one command, without ':' separator. It's possible to have many command in a line.
  **/
 class Command : private std::vector<Token*> {
 	public:
-		Command(const std::vector<Token*>& aTokens) : std::vector<Token*>(aTokens) {}
-
-		unsigned execute() const {
-			auto itToken = std::vector<Token*>::cbegin();
-
-			while (itToken != std::vector<Token*>::cend()) {
-				if (const auto pTC = dynamic_cast<const TokenComment*>(*itToken)) {
-					++itToken;
-					continue;
-				} else if (const auto pTI = dynamic_cast<const TokenInstruction*>(*itToken)) {
-					switch (pTI->getId()) {
-						case 20:
-													
-							
-						default:
-							std::cerr << "Instruction " << pTI->getString() << " inconnue !" << std::endl;
-							exit(-1);
-					}
-				} else {
-					std::cerr << "Token " << **itToken << " inconnue !" << std::endl;
-					exit(-1);
-				}
-
-			}
+		Command(const std::vector<Token*>& aTokens, const unsigned aLine = 0) : std::vector<Token*>(aTokens), line(aLine) {}
+
+		/**
+		 * A command already compiled, without tokens.
+		 **/
+		Command(Statement* aStatement, const unsigned aLine) : statement(aStatement), line(aLine) {}
+
+		/**
+		 * Slice the tokens of a line at the first ':' separator.
+		 * @param aStart Iterator on the first token, then after the separator.
+		 * @param aStop Iterator after the last token.
+		 * @param aLine Number of the line.
+		 **/
+		static Command slice(std::vector<Token*>::const_iterator& aStart, const std::vector<Token*>::const_iterator& aStop, const unsigned aLine);
+
+		/**
+		 * Compile the tokens into the statement executed by execute().
+		 * @return OK or the error found (usually a SYNTAX_ERROR).
+		 **/
+		Error::error_t compile(Runtime& aRuntime);
+
+		/**
+		 * Execute the command.
+		 * @return OK or the error met, the caller decides what to do with it.
+		 **/
+		Error::error_t execute(Runtime& aRuntime) const {
+			return statement->execute(aRuntime);
+		}
+
+		/**
+		 * Resolve the line numbers of the statement, once the whole program is loaded.
+		 * @param aPosition Position of the command in aProgram.
+		 **/
+		void link(const Program& aProgram, const Position& aPosition) {
+			statement->link(aProgram, aPosition);
+		}
 
+		/**
+		 * Add the line numbers the statement jumps to.
+		 **/
+		void references(std::set<unsigned>& aLines) const {
+			statement->references(aLines);
+		}
+
+		/**
+		 * RENUM: move the command to another line, and write the new numbers of the lines it references,
+		 * in its statement and in its tokens. The references to lines not renumbered are left as they are.
+		 * @param aLine New number of the line of the command.
+		 **/
+		void renumber(const unsigned aLine, const Renumbering& aNumbers);
+
+		/**
+		 * Forget the tokens once compiled, when the source text is kept elsewhere.
+		 * The tokens are not deleted, they belong to the caller.
+		 **/
+		void strip() {
+			std::vector<Token*>().swap(*this);
+		}
+
+		const Statement* getStatement() const {
+			return statement.get();
+		}
+
+		unsigned getLine() const {
+			return line;
 		}
 
 		friend std::ostream& operator<<(std::ostream&, const Command&);
+
+	private:
+		///< Compiled form of the tokens, shared by the copies of the command.
+		std::shared_ptr<Statement> statement;
+
+		///< Number of the line where the command is written.
+		unsigned line;
 };
 
 /*
@@ -74,11 +129,11 @@ std::ostream& operator<<(std::ostream& out, const Command& aCommand)
 }
 */
 
-std::ostream& operator<<(std::ostream& out, const Command& aCommand) {
-	return out << static_cast<std::vector<Token*> >(aCommand);
+inline std::ostream& operator<<(std::ostream& out, const Command& aCommand) {
+	return out << static_cast<const std::vector<Token*>&>(aCommand);
 }
 
-std::ostream& operator<<(std::ostream& out, const std::vector<Command>& aCommands) {
+inline std::ostream& operator<<(std::ostream& out, const std::vector<Command>& aCommands) {
 	for (auto&& command : aCommands)	{
 		out << (&command == &(*aCommands.cbegin()) ? "" : " : ") << command;
 	}
@@ -0,0 +1,143 @@
+/**
+ * Copyright [2024] Marc SIBERT
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#pragma once
+
+#include <memory>
+
+#include "metrics.h"
+#include "program.h"
+#include "value.h"
+
+#ifndef CONTROL_STACK_DEPTH
+///< Default number of frames of the control stack: GOSUB, FOR and WHILE nested at a time.
+#define CONTROL_STACK_DEPTH 256
+#endif
+
+/**
+ * Frame of the control stack, pushed by GOSUB, FOR and WHILE.
+ **/
+struct Frame {
+	enum kind_t { GOSUB, FOR, WHILE } kind;
+	Position back;			///< Command following the GOSUB or the FOR, or the WHILE itself.
+	unsigned variable;		///< FOR only, the loop variable.
+	Value limit;			///< FOR only, of the type of the variable.
+	Value step;				///< FOR only, of the type of the variable.
+};
+
+/**
+ * Stack of the active GOSUB, FOR and WHILE, allocated once with a fixed depth:
+ * nothing is allocated while running, and an overflow is an "Out of memory" error as in GW-BASIC.
+ **/
+class ControlStack {
+	public:
+		explicit ControlStack(const unsigned aDepth = CONTROL_STACK_DEPTH) :
+			frames(new Frame[aDepth]),
+			depth(aDepth),
+			count(0),
+			peak(0) {
+		}
+
+		/**
+		 * Push a frame, to be filled by the caller.
+		 * @return nullptr if the stack is full.
+		 **/
+		Frame* push(const Frame::kind_t aKind) {
+			if (count == depth) return nullptr;
+			Frame* frame = &frames[count++];
+#if METRICS
+			if (count > peak) peak = count;
+#endif
+			frame->kind = aKind;
+			return frame;
+		}
+
+		/**
+		 * Remove the frames above aSize.
+		 **/
+		void resize(const unsigned aSize) {
+			count = aSize;
+		}
+
+		void clear() {
+			count = 0;
+		}
+
+		unsigned size() const {
+			return count;
+		}
+
+		Frame& operator[](const unsigned aIndex) {
+			return frames[aIndex];
+		}
+
+		const Frame& operator[](const unsigned aIndex) const {
+			return frames[aIndex];
+		}
+
+		unsigned capacity() const {
+			return depth;
+		}
+
+		/**
+		 * Most frames in use at a time, always 0 if METRICS is 0.
+		 **/
+		unsigned highWater() const {
+			return peak;
+		}
+
+		/**
+		 * Start the high water mark again from the frames in use.
+		 **/
+		void resetHighWater() {
+			peak = count;
+		}
+
+		/**
+		 * Find the innermost frame of a kind, above the innermost GOSUB unless a GOSUB is searched:
+		 * NEXT and WEND cannot close a loop opened before the subroutine was called.
+		 * @param aIndex Index of the frame found.
+		 * @param aVariable For a FOR, the loop variable, or -1 for any.
+		 * @return false if there is no such frame.
+		 **/
+		bool find(const Frame::kind_t aKind, unsigned& aIndex, const unsigned aVariable = -1) const {
+			for (aIndex = count; aIndex-- > 0; ) {
+				const Frame& frame = frames[aIndex];
+				if ((frame.kind == aKind) && ((aKind != Frame::FOR) || (aVariable == unsigned(-1)) || (frame.variable == aVariable))) return true;
+				if (frame.kind == Frame::GOSUB) return false;
+			}
+			return false;
+		}
+
+		/**
+		 * Find the frame of the WHILE at aWhile, above the innermost GOSUB.
+		 * @return false if that WHILE is not running.
+		 **/
+		bool find(const Position& aWhile, unsigned& aIndex) const {
+			for (aIndex = count; aIndex-- > 0; ) {
+				const Frame& frame = frames[aIndex];
+				if ((frame.kind == Frame::WHILE) && (frame.back.line == aWhile.line) && (frame.back.index == aWhile.index)) return true;
+				if (frame.kind == Frame::GOSUB) return false;
+			}
+			return false;
+		}
+
+	private:
+		std::unique_ptr<Frame[]> frames;
+		const unsigned depth;
+		unsigned count;				///< Frames in use.
+		unsigned peak;				///< Of count.
+};
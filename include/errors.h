@@ -0,0 +1,62 @@
+/**
+ * Copyright [2024] Marc SIBERT
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#pragma once
+
+/**
+ * Errors raised while loading or running a program.
+ **/
+class Error {
+	public:
+		/**
+		 * Error codes, numbered like the GW-BASIC ERR values.
+		 **/
+		enum error_t {
+			OK = 0,
+			NEXT_WITHOUT_FOR = 1,
+			SYNTAX_ERROR = 2,
+			RETURN_WITHOUT_GOSUB = 3,
+			OUT_OF_DATA = 4,
+			ILLEGAL_FUNCTION_CALL = 5,
+			OVERFLOW_ERROR = 6,
+			OUT_OF_MEMORY = 7,
+			LINE_NOT_FOUND = 8,
+			SUBSCRIPT_OUT_OF_RANGE = 9,
+			DUPLICATE_DEFINITION = 10,
+			DIVISION_BY_ZERO = 11,
+			TYPE_MISMATCH = 13,
+			STRING_TOO_LONG = 15,
+			RESUME_WITHOUT_ERROR = 20,
+			FOR_WITHOUT_NEXT = 26,
+			WHILE_WITHOUT_WEND = 29,
+			WEND_WITHOUT_WHILE = 30,
+			FIELD_OVERFLOW = 50,
+			BAD_FILE_NUMBER = 52,
+			FILE_NOT_FOUND = 53,
+			BAD_FILE_MODE = 54,
+			FILE_ALREADY_OPEN = 55,
+			DEVICE_IO_ERROR = 57,
+			INPUT_PAST_END = 62,
+			BAD_RECORD_NUMBER = 63,
+			ADVANCED_FEATURE = 73,
+			UNCOMPILED = 256		///< Not a GW-BASIC error: a line of the lazy load to compile before running it.
+		};
+
+		/**
+		 * Return the GW-BASIC message matching an error code.
+		 **/
+		static const char* message(const error_t aError);
+};
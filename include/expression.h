@@ -0,0 +1,155 @@
+/**
+ * Copyright [2024] Marc SIBERT
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#pragma once
+
+#include <vector>
+
+#include "value.h"
+
+class Runtime;
+class Parser;
+
+/**
+ * An expression compiled once at load time into Reverse Polish Notation.
+ * Evaluating it is a single loop over a flat array of operations working on the runtime stack.
+ **/
+class Expression {
+	public:
+		/**
+		 * Operations are specialized by the parser for the types of their operands, known when compiling:
+		 * the INTEGER, SINGLE and DOUBLE variants of an operation follow each other in this order.
+		 **/
+		enum opcode_t {
+			PUSH_CONSTANT, PUSH_STRING_CONSTANT, PUSH_VARIABLE, PUSH_STRING_VARIABLE, PUSH_ELEMENT, CALL,
+			INTEGER_TO_SINGLE, INTEGER_TO_DOUBLE, SINGLE_TO_INTEGER,	///< Convert the value arg places below the top (1 for the top).
+			SINGLE_TO_DOUBLE, DOUBLE_TO_INTEGER, DOUBLE_TO_SINGLE,
+			NEGATE_INTEGER, NEGATE_SINGLE, NEGATE_DOUBLE, NOT,
+			ADD_INTEGER, ADD_SINGLE, ADD_DOUBLE, CONCAT,
+			SUBTRACT_INTEGER, SUBTRACT_SINGLE, SUBTRACT_DOUBLE,
+			MULTIPLY_INTEGER, MULTIPLY_SINGLE, MULTIPLY_DOUBLE,
+			DIVIDE_SINGLE, DIVIDE_DOUBLE,
+			POWER_SINGLE, POWER_DOUBLE,
+			INTEGER_DIVIDE, MODULO, AND, OR, XOR, EQV, IMP,
+			COMPARE_INTEGER, COMPARE_SINGLE, COMPARE_DOUBLE, COMPARE_STRING	///< arg is the relation_t.
+		};
+
+		/**
+		 * Relational operators, as the argument of the COMPARE operations.
+		 **/
+		enum relation_t {
+			EQUAL, NOT_EQUAL, LESS, GREATER, LESS_EQUAL, GREATER_EQUAL
+		};
+
+		enum function_t {
+			ABS, ASC, ATN, CDBL, CHR, CINT, COS, CSNG, CVD, CVI, CVS, END_OF_FILE, ERL, ERR, EXP, FIX, HEX, INSTR, INT,
+			LEFT, LEN, LOC, LOF, LOG, MID, MKD, MKI, MKS, OCT, POS, RIGHT, RND, SGN, SIN, SPACE, SPC, SQR,
+			STR, STRING, TAB, TAN, VAL
+		};
+
+		///< Most dimensions an array can have.
+		static const unsigned MAX_DIMENSIONS = 8;
+
+		Expression() : type(Token::SINGLE), depth(0), maxDepth(0) {}
+
+		/**
+		 * Find a function by name, with the number of arguments it accepts and its signature.
+		 * The signature gives the type of the result, then the one of each argument:
+		 * '%', '!', '#' and '$' for INTEGER, SINGLE, DOUBLE and STRING, 'N' for any number,
+		 * '=' for the type of the first argument, '~' for DOUBLE if the first argument is, SINGLE otherwise,
+		 * and '*' for an argument of any type.
+		 * @return false if the name is not a known function.
+		 **/
+		static bool function(const std::string& aName, function_t& aFunction, unsigned& aMin, unsigned& aMax, const char*& aSignature);
+
+		bool empty() const {
+			return operations.empty();
+		}
+
+		/**
+		 * Type of the result, known when compiling.
+		 **/
+		Token::type_t getType() const {
+			return type;
+		}
+
+		/**
+		 * The value of an expression made of a single constant, known when compiling.
+		 * @return nullptr if the expression is not a constant.
+		 **/
+		const Value* constant() const {
+			return ((operations.size() == 1) && ((operations[0].code == PUSH_CONSTANT) || (operations[0].code == PUSH_STRING_CONSTANT))) ? &constants[operations[0].arg] : nullptr;
+		}
+
+		/**
+		 * Evaluate the expression.
+		 **/
+		Error::error_t evaluate(Runtime& aRuntime, Value& aResult) const;
+
+		/**
+		 * Evaluate an expression compiled as an INTEGER.
+		 **/
+		Error::error_t evaluate(Runtime& aRuntime, int16_t& aResult) const;
+
+	private:
+		friend class Parser;
+
+		struct Operation {
+			opcode_t code;
+			unsigned arg;		///< Constant, variable, array or function index.
+			unsigned count;		///< Number of indexes or arguments.
+		};
+
+		/**
+		 * Run the operations, leaving the result on the top of the runtime stack.
+		 **/
+		Error::error_t run(Runtime& aRuntime, Value*& aTop) const;
+
+		/**
+		 * Append an operation, tracking the depth of the stack it needs.
+		 **/
+		void emit(const opcode_t aCode, const unsigned aArg = 0, const unsigned aCount = 0);
+
+		std::vector<Operation> operations;
+		std::vector<Value> constants;
+		Token::type_t type;
+
+		unsigned depth;			///< Stack depth after the last operation emitted.
+		unsigned maxDepth;		///< Stack depth needed to evaluate.
+};
+
+/**
+ * A place a value can be stored in: a simple variable or an array element.
+ **/
+class Lvalue {
+	public:
+		Lvalue() : slot(0), array(false), type(Token::SINGLE) {}
+
+		/**
+		 * Find the value designated, evaluating the indexes of an array element.
+		 **/
+		Error::error_t resolve(Runtime& aRuntime, Value*& aValue) const;
+
+		/**
+		 * Store a value, converted to the type of the variable.
+		 **/
+		Error::error_t assign(Runtime& aRuntime, const Value& aValue) const;
+
+		unsigned slot;						///< Variable or array index in the runtime.
+		bool array;
+		Token::type_t type;
+		std::vector<Expression> indexes;	///< Only for an array element.
+};
@@ -0,0 +1,186 @@
+/**
+ * Copyright [2024] Marc SIBERT
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#pragma once
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "errors.h"
+#include "value.h"
+
+#ifndef FILE_CHANNELS
+///< Default number of channels, #1 to #FILE_CHANNELS.
+#define FILE_CHANNELS 15
+#endif
+
+#ifndef FILE_CACHE_BLOCKS
+///< Default number of blocks of the cache shared by the random files.
+#define FILE_CACHE_BLOCKS 64
+#endif
+
+#ifndef FILE_BLOCK_SIZE
+///< Bytes of a block of the cache.
+#define FILE_BLOCK_SIZE 4096
+#endif
+
+#ifndef FILE_BUFFER_SIZE
+///< Bytes of the buffer of each sequential file.
+#define FILE_BUFFER_SIZE 65536
+#endif
+
+/**
+ * A file open on a channel.
+ **/
+struct File {
+	enum mode_t { INPUT, OUTPUT, APPEND, RANDOM };
+
+	/**
+	 * A FIELD variable, standing for bytes of the record.
+	 **/
+	struct Field {
+		unsigned offset;
+		unsigned width;
+		unsigned variable;			///< Slot of the STRING variable.
+	};
+
+	mode_t mode;
+	std::fstream stream;
+	std::vector<char> buffer;		///< Of the stream, sequential files only.
+	unsigned length;				///< Of a record, random files only.
+	unsigned long size;				///< In bytes, records PUT in the cache included.
+	unsigned long record;			///< Last record read or written, for LOC and the GET or PUT without number.
+	bool end;						///< The last GET was past the end of the file.
+	std::vector<Field> fields;
+	unsigned column;				///< Of PRINT #, 0 based.
+};
+
+/**
+ * Blocks of the random files, shared by all the channels, the least recently used being reused first.
+ * A block is written back when reused, or when its file is closed.
+ **/
+class BlockCache {
+	public:
+		explicit BlockCache(const unsigned aBlocks = FILE_CACHE_BLOCKS) :
+			count(aBlocks),
+			clock(0),
+			last(nullptr) {
+		}
+
+		/**
+		 * Copy bytes of a file, zeros past its end.
+		 **/
+		Error::error_t read(File& aFile, const unsigned long aPosition, char* aData, const unsigned long aSize);
+
+		/**
+		 * Copy bytes to a file, extending it if needed.
+		 **/
+		Error::error_t write(File& aFile, const unsigned long aPosition, const char* aData, const unsigned long aSize);
+
+		/**
+		 * Set bytes of a file to a character, extending it if needed.
+		 **/
+		Error::error_t fill(File& aFile, const unsigned long aPosition, const char aChar, const unsigned long aSize);
+
+		/**
+		 * Write back and forget the blocks of a file, before it is closed.
+		 **/
+		Error::error_t flush(File& aFile);
+
+	private:
+		struct Block {
+			File* file;				///< nullptr if free.
+			unsigned long number;	///< Offset in the file, in blocks.
+			unsigned long used;		///< Clock of the last use, 0 if free.
+			bool dirty;
+			char* data;
+		};
+
+		/**
+		 * Find the block of a file, loading it in the least recently used block if needed.
+		 **/
+		Error::error_t fetch(File& aFile, const unsigned long aNumber, Block*& aBlock);
+
+		/**
+		 * Apply aCopy(block data, bytes) to each block a range of a file spans.
+		 **/
+		template<class F> Error::error_t span(File& aFile, unsigned long aPosition, unsigned long aSize, const bool aWrite, F aCopy);
+
+		Error::error_t writeBack(Block& aBlock);
+
+		const unsigned count;
+		std::vector<Block> blocks;		///< Allocated with the first block used.
+		std::vector<char> storage;
+		unsigned long clock;
+		Block* last;					///< Block used last, looked up first.
+};
+
+/**
+ * The channels and the files open on them.
+ **/
+class Files {
+	public:
+		explicit Files(const unsigned aBlocks = FILE_CACHE_BLOCKS) : cache(aBlocks) {}
+
+		~Files() {
+			closeAll();
+		}
+
+		/**
+		 * Open a file on a channel.
+		 * @param aLength Of a record, random files only.
+		 * @return BAD_FILE_NUMBER out of #1 to #FILE_CHANNELS, FILE_ALREADY_OPEN if the channel is in use,
+		 * FILE_NOT_FOUND if the file cannot be opened.
+		 **/
+		Error::error_t open(const int aChannel, const std::string& aName, const File::mode_t aMode, const int aLength);
+
+		/**
+		 * Close the file of a channel, writing back its blocks first. Nothing to do if the channel is not in use.
+		 **/
+		Error::error_t close(const int aChannel);
+
+		/**
+		 * Close all the files, returning the first error met.
+		 **/
+		Error::error_t closeAll();
+
+		/**
+		 * Return the file open on a channel.
+		 * @return BAD_FILE_NUMBER if none.
+		 **/
+		Error::error_t get(const int aChannel, File*& aFile) {
+			if ((aChannel < 1) || (aChannel > FILE_CHANNELS) || !channels[aChannel - 1]) return Error::BAD_FILE_NUMBER;
+			aFile = channels[aChannel - 1].get();
+			return Error::OK;
+		}
+
+		/**
+		 * GET: copy a record in the FIELD variables, which keep their storage.
+		 * @param aRecord 1 based.
+		 **/
+		Error::error_t read(File& aFile, const unsigned long aRecord, std::vector<Value>& aVariables);
+
+		/**
+		 * PUT: copy the FIELD variables in a record, padded with spaces or truncated to their width.
+		 **/
+		Error::error_t write(File& aFile, const unsigned long aRecord, const std::vector<Value>& aVariables);
+
+	private:
+		std::unique_ptr<File> channels[FILE_CHANNELS];
+		BlockCache cache;
+};
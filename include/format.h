@@ -0,0 +1,92 @@
+/**
+ * Copyright [2024] Marc SIBERT
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "errors.h"
+#include "value.h"
+
+class Runtime;
+
+/**
+ * The format string of PRINT USING, compiled once into its literal text and its fields.
+ * The numbers are written digit by digit in a buffer on the stack, then printed at once.
+ **/
+class Format {
+	public:
+		/**
+		 * A field of the format, or a run of literal text.
+		 **/
+		struct Field {
+			enum kind_t { LITERAL, FIRST, FIXED, WHOLE, NUMBER } kind;	///< Text, !, \  \, & or #.
+			unsigned offset;			///< Of a LITERAL in text.
+			unsigned length;			///< Of a LITERAL, or characters of a FIXED field.
+
+			unsigned before;			///< Positions left of the point, $ and commas included.
+			unsigned after;				///< Digits right of the point.
+			unsigned exponent;			///< Digits of the exponent, 0 for none.
+			bool point;
+			bool comma;					///< A comma every 3 digits left of the point.
+			bool asterisk;				///< Leading spaces written as '*'.
+			bool dollar;				///< '$' just left of the number.
+			bool leadingSign;			///< '+' or '-' before the number.
+			bool trailingPlus;			///< '+' or '-' after the number.
+			bool trailingMinus;			///< '-' or ' ' after the number.
+		};
+
+		Format() : values(0) {}
+
+		/**
+		 * Compile a format string.
+		 * @return ILLEGAL_FUNCTION_CALL if it holds no field, or a field of more than 24 digits.
+		 **/
+		Error::error_t compile(const std::string& aFormat);
+
+		/**
+		 * Write the literal text up to the next field, then a value in this field, the format starting over
+		 * once all its fields are used.
+		 * @param aNext Index of the next field, 0 to start, updated.
+		 * @return TYPE_MISMATCH if a string goes in a numeric field, or a number in a string one.
+		 **/
+		Error::error_t print(Runtime& aRuntime, const Value& aValue, unsigned& aNext) const;
+
+		/**
+		 * Write the literal text following the last value, up to the next field.
+		 **/
+		void finish(Runtime& aRuntime, unsigned aNext) const;
+
+		/**
+		 * Write a number as a numeric field formats it.
+		 * @param aBuffer Of at least BUFFER_SIZE characters.
+		 * @return The characters written.
+		 **/
+		static unsigned number(const Field& aField, const Value& aValue, char* aBuffer);
+
+		static const unsigned BUFFER_SIZE = 512;
+
+	private:
+		/**
+		 * Write the runs of literal text from aNext, up to the next field or the end of the format.
+		 **/
+		void literals(Runtime& aRuntime, unsigned& aNext) const;
+
+		std::string text;				///< Literal characters of all the runs.
+		std::vector<Field> fields;		///< In the order of the format.
+		unsigned values;				///< Fields which are not LITERAL.
+};
@@ -27,39 +27,533 @@
 
 #include "tokenizer.h"
 #include "command.h"
+#include "memstat.h"
+#include "metrics.h"
+#include "runtime.h"
+#include "snapshot.h"
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cctype>
+#include <fstream>
 #include <iomanip>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#ifdef _WIN32
 #include <heapapi.h>
+#else
+#include <unistd.h>
+#endif
+
+/**
+ * A program loaded, with what LIST and the lazy compilation need.
+ * Always allocated apart: its statements keep positions in it, and CHAIN keeps it aside once compiled.
+ **/
+struct Image {
+	Image(Runtime& aRuntime, const std::string& aName) : name(aName), lazy(aRuntime, program) {}
+
+	std::string name;			///< File the program was loaded from, empty if unknown.
+	Program program;
+
+	///< Source of the lines not compiled yet, in LAZY mode.
+	LazySource lazy;
+
+	///< Text of each line following its number, only kept by the optimized load for LIST.
+	std::map<unsigned, std::string> source;
+
+	/**
+	 * Find where a line starts, even once the optimized load appended it to the preceding one.
+	 * @return false if there is no such line.
+	 **/
+	bool locate(const unsigned aNumber, Position& aPosition) const {
+		auto itLine = program.upper_bound(aNumber);
+		if (itLine == program.cbegin()) return false;
+		--itLine;
+		if ((itLine->first != aNumber) && !source.count(aNumber)) return false;
+		aPosition.line = itLine;
+		aPosition.index = 0;
+		while ((aPosition.index < itLine->second.size()) && (itLine->second[aPosition.index].getLine() < aNumber)) ++aPosition.index;
+		aPosition.settle(program);
+		return true;
+	}
+};
 
 class Interpreter {
 	public:
-		enum error_t {
-			OK,
-			SYNTAX_ERROR,
-            LINE_NOT_FOUND
-		};
+		typedef Error::error_t error_t;
+
+		/**
+		 * How load() prepares the programs.
+		 **/
+		typedef enum {
+			EAGER,			///< Compile every line.
+			OPTIMIZED,		///< Compile every line, then compact() the program.
+			LAZY			///< Only read the line numbers, each line is compiled when first run or listed.
+		} mode_t;
 
         /**
          * Initiate the interpreter with the usual 3 streams (cin, cout & cerr).
+         * @param aDepth GOSUB, FOR and WHILE which can be nested.
          **/
-		Interpreter(std::istream& aIn = std::cin, std::ostream& aOut = std::cout, std::ostream& aErr = std::cerr) :
+		Interpreter(std::istream& aIn = std::cin, std::ostream& aOut = std::cout, std::ostream& aErr = std::cerr, const unsigned aDepth = CONTROL_STACK_DEPTH, const mode_t aMode = EAGER) :
 			in(aIn),
 			out(aOut),
-			err(aErr) {
+			err(aErr),
+			runtime(aIn, aOut, aErr, aDepth),
+			mode(aMode),
+			image(new Image(runtime, "")) {
+		}
+
+		/**
+		 * Load a file in program memory, compiling every command, or none in LAZY mode.
+		 * @param aName Name of the file, for CHAIN to find the program compiled when chaining back to it.
+		 **/
+		error_t load(std::istream& aFile, const std::string& aName = "") {
+			chained.clear();
+			image.reset(new Image(runtime, aName));
+			runtime.reset();
+			return read(aFile);
+		}
+
+		/**
+		 * List the lines from start to stop, written straight into the output stream.
+		 **/
+		error_t list(const unsigned start=0, const unsigned stop=65535) const {
+			const Program& program = image->program;
+			if (mode == OPTIMIZED) {
+				for (auto itLine = image->source.lower_bound(start); (itLine != image->source.cend()) && (itLine->first <= stop); ++itLine) {
+					out << std::setw(5) << itLine->first << ' ' << itLine->second << '\n';
+				}
+				out.flush();
+				return Error::OK;
+			}
+			for (auto itLine = program.lower_bound(start); (itLine != program.cend()) && (itLine->first <= stop); ++itLine) {
+				out << std::setw(5) << itLine->first << ' ';
+				// A line not compiled yet is listed from its source text, as written.
+				const auto pLazy = itLine->second.empty() ? nullptr : dynamic_cast<const StatementLazy*>(itLine->second[0].getStatement());
+				if (pLazy) pLazy->list(out);
+				else out << itLine->second;
+				out << '\n';
+			}
+			out.flush();
+			return Error::OK;
+		}
+
+		/**
+		 * RENUM: number the lines from aOld on aNew, aNew + aIncrement..., and the references to them.
+		 * The lines are moved in the index and the references remapped in one pass, nothing is compiled again:
+		 * the lines not compiled yet by the lazy load get their text renumbered.
+		 * @return ILLEGAL_FUNCTION_CALL if the lines would not stay in the same order or pass 65529,
+		 * or if the optimized load fused them.
+		 **/
+		error_t renumber(const unsigned aNew = 10, const unsigned aOld = 0, const unsigned aIncrement = 10) {
+			Program& program = image->program;
+			if ((mode == OPTIMIZED) || !aIncrement) return Error::ILLEGAL_FUNCTION_CALL;
+
+			const auto first = program.lower_bound(aOld);
+			const auto count = std::distance(first, program.end());
+			if ((first != program.begin()) && (std::prev(first)->first >= aNew)) return Error::ILLEGAL_FUNCTION_CALL;
+			if (count && (aNew + (count - 1) * static_cast<unsigned long long>(aIncrement) > MAX_LINE_NUMBER)) return Error::ILLEGAL_FUNCTION_CALL;
+
+			Renumbering numbers;
+			numbers.reserve(count);
+			unsigned number = aNew;
+			for (auto itLine = first; itLine != program.end(); ++itLine, number += aIncrement) numbers.push_back(std::make_pair(itLine->first, number));
+
+			Program renumbered;
+			std::string text;
+			auto itNumber = numbers.cbegin();
+			for (auto&& line : program) {
+				const unsigned number = line.first < aOld ? line.first : (itNumber++)->second;
+				for (auto&& command : line.second) {
+					// The lines not compiled yet hold their references in their text, written again after the source.
+					const auto pLazy = dynamic_cast<const StatementLazy*>(command.getStatement());
+					if (pLazy && pLazy->renumber(numbers, text)) {
+						command = Command(new StatementLazy(image->lazy, image->lazy.text.size(), text.size(), pLazy->getDefaults()), number);
+						image->lazy.text += text;
+					} else command.renumber(number, numbers);
+				}
+				renumbered.emplace_hint(renumbered.end(), number, std::move(line.second));
+			}
+			program.swap(renumbered);
+			edited();
+			return Error::OK;
+		}
+
+		/**
+		 * DELETE: remove the line aFirst only.
+		 * @return ILLEGAL_FUNCTION_CALL if there is no line aFirst, or if the optimized load fused the lines.
+		 **/
+		error_t erase(const unsigned aFirst) {
+			return erase(aFirst, aFirst);
+		}
+
+		/**
+		 * DELETE -aLast: remove the lines from the first one to aLast.
+		 * @return ILLEGAL_FUNCTION_CALL if there is no line up to aLast, or if the optimized load fused the lines.
+		 **/
+		error_t eraseUpTo(const unsigned aLast) {
+			const Program& program = image->program;
+			if (program.empty() || (program.cbegin()->first > aLast)) return Error::ILLEGAL_FUNCTION_CALL;
+			return erase(program.cbegin()->first, aLast);
+		}
+
+		/**
+		 * DELETE: remove the lines from aFirst to aLast.
+		 * @return ILLEGAL_FUNCTION_CALL if there is no line aFirst, or if the optimized load fused the lines.
+		 **/
+		error_t erase(const unsigned aFirst, const unsigned aLast) {
+			Program& program = image->program;
+			if ((mode == OPTIMIZED) || !program.count(aFirst) || (aLast < aFirst)) return Error::ILLEGAL_FUNCTION_CALL;
+
+			program.erase(program.lower_bound(aFirst), program.upper_bound(aLast));
+			edited();
+			return Error::OK;
+		}
+
+		/**
+		 * MERGE: add the lines of a file to the program, replacing the lines of the same numbers.
+		 * Only the lines merged are tokenized, the others stay compiled as they are. As a file loaded, the file
+		 * merged starts with every variable SINGLE, whatever the DEFINT... of the program, and its own ones
+		 * only apply to the lines after them in the file.
+		 * @return ILLEGAL_FUNCTION_CALL if the optimized load fused the lines.
+		 **/
+		error_t merge(std::istream& aFile) {
+			if (mode == OPTIMIZED) return Error::ILLEGAL_FUNCTION_CALL;
+
+			LazySource& lazy = image->lazy;
+			std::fill(std::begin(runtime.defaults), std::end(runtime.defaults), Token::SINGLE);
+			if (!std::equal(std::begin(runtime.defaults), std::end(runtime.defaults), lazy.defaults.back().cbegin())) {
+				lazy.defaults.push_back(std::array<Token::type_t, 26>());
+				std::copy(std::begin(runtime.defaults), std::end(runtime.defaults), lazy.defaults.back().begin());
+			}
+
+			const auto error = parse(aFile);
+			edited();
+			return error;
+		}
+
+		/**
+		 * Run the current inmemory program.
+		 * @param start Line to start from, dafault starts at the first line.
+		 * @return the execussion code.
+		 */
+		error_t run(const unsigned start=0) {
+			runtime.files.closeAll();
+			runtime.clear(image->program);
+			if (start) {
+				const auto error = runtime.jump(start);
+				if (error) return error;
+			}
+			return execute();
+		}
+
+		/**
+		 * Go on with the run where it stopped, like CONT: after a STOP, or where the snapshot restored was taken.
+		 **/
+		error_t cont() {
+			if (runtime.program != &image->program) return run();
+			if (runtime.pc.line == image->program.cend()) {
+				runtime.pc = runtime.stopped;
+				runtime.stopped.line = image->program.cend();
+			}
+			return execute();
+		}
+
+		/**
+		 * Write a snapshot of the program and of its run, to be restored in another interpreter, even in
+		 * another process, and go on with cont(). The program is written as text and compiled again when
+		 * restored: a LAZY interpreter restores it in the time it takes to read it.
+		 **/
+		error_t snapshot(std::ostream& aOut) {
+			if (runtime.program != &image->program) runtime.clear(image->program);
+
+			std::ostringstream text;
+			if (mode == OPTIMIZED) {
+				for (auto&& line : image->source) text << line.first << ' ' << line.second << '\n';
+			} else {
+				for (auto&& line : image->program) {
+					text << line.first << ' ';
+					// The lines not compiled yet are not compiled for that.
+					const auto pLazy = line.second.empty() ? nullptr : dynamic_cast<const StatementLazy*>(line.second[0].getStatement());
+					if (pLazy) pLazy->list(text);
+					else text << line.second;
+					text << '\n';
+				}
+			}
+
+			Snapshot::put(aOut, std::string(magic()));
+			Snapshot::put(aOut, image->name);
+			Snapshot::put(aOut, text.str());
+			runtime.save(aOut);
+			return aOut ? Error::OK : Error::DEVICE_IO_ERROR;
 		}
 
 		/**
-		 * Load a file in program memory.
+		 * Replace the program and the state of its run by a snapshot, cont() going on with the run.
+		 * @return BAD_FILE_MODE if this is not a snapshot, or a corrupted one.
 		 **/
-		error_t load(std::ifstream& aFile) {
-			program.clear();	// empty current program
+		error_t restore(std::istream& aIn) {
+			std::string magic, name, text;
+			if (!Snapshot::get(aIn, magic) || (magic != this->magic()) || !Snapshot::get(aIn, name) || !Snapshot::get(aIn, text)) return Error::BAD_FILE_MODE;
+
+			std::istringstream program(text);
+			const auto error = load(program, name);
+			if (error) return error;
+			runtime.files.closeAll();
+			runtime.clear(image->program);
+			return runtime.restore(aIn);
+		}
+
+		/**
+		 * True if the program stopped on STOP, cont() going on with it.
+		 **/
+		bool isStopped() const {
+			return (runtime.program == &image->program) && (runtime.stopped.line != image->program.cend());
+		}
+
+		/**
+		 * Number of commands executed by the last run.
+		 **/
+		unsigned long long getStatements() const {
+			return statements;
+		}
+
+		/**
+		 * Counters of the run, to be read from any thread with snapshot() while it goes on.
+		 **/
+		const Metrics& getMetrics() const {
+			return metrics;
+		}
+
+		/**
+		 * Slice each tokens' list in separate commands, using ':' separator.
+		 * @param start Iterator on first token.
+		 * @param stop Iterator after the last token.
+		 * @param line Number of the line.
+		 * @return A vector of tokens.
+		 **/
+		Command commandSlicer(std::vector<Token*>::const_iterator& start, const std::vector<Token*>::const_iterator& stop, const unsigned line) {
+			return Command::slice(start, stop, line);
+		}
+
+
+		/**
+		 * Return a string describing the current interpreter.
+		 **/
+		std::string toString() const {
+			std::ostringstream s;
+			s << PRODUCT_NAME << ' ' << PRODUCT_VERSION << std::endl
+			  << "(C) Copyright M. SIBERT 2024" << std::endl
+			  << freeBytes() << " Bytes free" << std::endl
+			  << "Ok" << std::endl;
+
+			return s.str();
+		}
+
+	protected:
+		/**
+		 * Run from the program counter until the program ends, stops on an error, or CHAIN replaces it.
+		 **/
+		error_t execute() {
+			// All the counters are the ones of this run, RUN and CONT starting them again.
+			statements = 0;
+			std::fill(std::begin(runtime.operations), std::end(runtime.operations), 0);
+			runtime.control.resetHighWater();
+			error_t error = Error::OK;
+			for (;;) {
+				const auto end = image->program.cend();
+				while (runtime.pc.line != end) {
+					runtime.current = runtime.pc;
+					runtime.advance();
+					++statements;
+#if METRICS
+					if (!(statements & (Metrics::PERIOD - 1))) publish();
+#endif
+					error = runtime.current.line->second[runtime.current.index].execute(runtime);
+					if (error) {
+						// A line of the lazy load is compiled the first time it runs, then run from its first command,
+						// which is counted once run.
+						if (error == Error::UNCOMPILED) {
+							--statements;
+							error = image->lazy.expand(runtime.current.line);
+							if (!error) {
+								runtime.pc = runtime.current;
+								continue;
+							}
+						}
+						// ON ERROR GOTO only costs something once an error is raised.
+						if (runtime.trap(error)) {
+							error = Error::OK;
+							continue;
+						}
+						if (runtime.column) runtime.newline();
+						err << Error::message(error) << " in " << runtime.current.number() << std::endl;
+						break;
+					}
+				}
+				if (error || runtime.chain.file.empty()) break;
+
+				// The program stopped on CHAIN, which leaves it unchanged when it fails.
+				error = chain();
+				if (error) {
+					if (runtime.column) runtime.newline();
+					err << Error::message(error) << " in " << runtime.current.number() << std::endl;
+					break;
+				}
+			}
+			// Files are written back when the program stops, as END does.
+			runtime.files.closeAll();
+			out.flush();
+			publish();
+			return error;
+		}
+
+		/**
+		 * Publish the counters of the run, the heap ones being the ones of the calling thread.
+		 **/
+		void publish() {
+			Metrics::Counters counters;
+			counters.statements = statements;
+			std::copy(std::begin(runtime.operations), std::end(runtime.operations), counters.operations);
+			counters.allocations = MemStat::allocations();
+			counters.heapBytes = std::max(0LL, MemStat::current());
+			counters.heapPeak = MemStat::peak();
+			counters.controlStackPeak = runtime.control.highWater();
+			metrics.publish(counters);
+		}
+
+		/**
+		 * CHAIN: replace the program by the one requested, passing it the COMMON variables (all of them with ALL)
+		 * through a snapshot of them, and run it. A program is compiled the first time it is chained to, then
+		 * kept aside: the symbols of the runtime are never reset, so that it stays bound to them.
+		 **/
+		error_t chain() {
+			ChainRequest request;
+			std::swap(request, runtime.chain);
+
+			std::set<unsigned> variables, arrays;
+			if (!request.all) {
+				for (auto&& line : image->program) {
+					for (auto&& command : line.second) {
+						if (const auto pSC = dynamic_cast<const StatementCommon*>(command.getStatement())) {
+							variables.insert(pSC->getVariables().cbegin(), pSC->getVariables().cend());
+							arrays.insert(pSC->getArrays().cbegin(), pSC->getArrays().cend());
+						}
+					}
+				}
+			}
+			std::stringstream passed;
+			runtime.saveVariables(passed, request.all ? nullptr : &variables, request.all ? nullptr : &arrays);
+
+			std::unique_ptr<Image> next;
+			const auto itChained = chained.find(request.file);
+			if (itChained != chained.end()) {
+				next = std::move(itChained->second);
+				chained.erase(itChained);
+			} else {
+				std::ifstream file(request.file);
+				if (!file) return Error::FILE_NOT_FOUND;
+				next.reset(new Image(runtime, request.file));
+				image.swap(next);
+				const auto error = read(file);
+				image.swap(next);
+				if (error) return error;
+			}
+			Position start;
+			if (request.line && !next->locate(request.line, start)) {
+				chained[request.file] = std::move(next);
+				return Error::LINE_NOT_FOUND;
+			}
+
+			if (!image->name.empty()) chained[image->name] = std::move(image);
+			image = std::move(next);
+			gatherData();
+			runtime.clear(image->program);
+			if (request.line) runtime.pc = start;
+			return runtime.restoreVariables(passed);
+		}
+
+		/**
+		 * Collect the DATA items of the program: they are read in the order of the lines, whatever the flow of the program.
+		 **/
+		void gatherData() {
+			runtime.data.clear();
+			runtime.dataLines.clear();
+			for (auto&& l : image->program) {
+				for (auto&& command : l.second) {
+					if (const auto pSD = dynamic_cast<const StatementData*>(command.getStatement())) {
+						runtime.dataLines.insert(std::make_pair(l.first, runtime.data.size()));
+						runtime.data.insert(runtime.data.end(), pSD->getValues().cbegin(), pSD->getValues().cend());
+					}
+				}
+			}
+		}
+
+		/**
+		 * First bytes of a snapshot, changed with its format.
+		 **/
+		static const char* magic() {
+			return "MS-Basic snapshot 1";
+		}
+
+		/**
+		 * Compile a file in the current image, with the symbols of the runtime.
+		 **/
+		error_t read(std::istream& aFile) {
+			LazySource& lazy = image->lazy;
+			std::fill(std::begin(runtime.defaults), std::end(runtime.defaults), Token::SINGLE);
+			lazy.text.clear();
+			lazy.defaults.assign(1, std::array<Token::type_t, 26>());
+			std::copy(std::begin(runtime.defaults), std::end(runtime.defaults), lazy.defaults.back().begin());
+
+			const auto error = parse(aFile);
+			if (error) return error;
+
+			gatherData();
+
+			if (mode == OPTIMIZED) compact();
+
+			link();
+			return Error::OK;
+		}
+
+		/**
+		 * Compile the lines of a file in the current image, each replacing the line of the same number.
+		 **/
+		error_t parse(std::istream& aFile) {
+			Program& program = image->program;
+			LazySource& lazy = image->lazy;
 
 			std::string line;
 			while (std::getline(aFile, line)) {
+				if (!line.empty() && (line.back() == '\r')) line.pop_back();
 				// Empty line?
 				if (!line.length()) continue;
 
+				// READ needs all the DATA from the start, DEFINT, DEFSNG... type the lines following them,
+				// and CHAIN passes the COMMON variables of the whole program: these lines are compiled when loading, even lazily.
+				if ((mode == LAZY) && !mentions(line, "DATA") && !mentions(line, "DEF") && !mentions(line, "COMMON")) {
+					const auto number = line.find_first_not_of(' ');
+					const auto text = line.find_first_not_of("0123456789", number);
+					unsigned lineNumber;
+					if ((text == number) || !::lineNumber(line.substr(number, text - number), lineNumber)) {
+						err << "Syntax Error: A line number must be an INTEGER up to " << MAX_LINE_NUMBER << '!' << std::endl;
+						err << line << std::endl;
+						return Error::SYNTAX_ERROR;
+					}
+					const auto body = line.find_first_not_of(' ', text);
+					std::vector<Command> commands;
+					if (body != std::string::npos) {
+						commands.push_back(Command(new StatementLazy(lazy, lazy.text.size(), line.length() - body, lazy.defaults.size() - 1), lineNumber));
+						lazy.text.append(line, body, std::string::npos);
+					}
+					program[lineNumber] = commands;
+					continue;
+				}
+
 				Tokenizer tokenizer;
 				bool error;
 				int pos;
@@ -69,7 +563,7 @@ class Interpreter {
 					err << "Syntax Error in:" << std::endl;
 					err << line << std::endl;
 					err << std::string(pos, ' ') << '^' << std::endl;
-					return SYNTAX_ERROR;
+					return Error::SYNTAX_ERROR;
 				}
 
 				auto itToken = tokens.cbegin();
@@ -78,83 +572,111 @@ class Interpreter {
 				if (!pTC)  {
 					err << "Syntax Error: A line number must be an CONSTANT!" << std::endl;
 					err << line << std::endl;
-					return SYNTAX_ERROR;
+					return Error::SYNTAX_ERROR;
 				}
 
-				if (pTC->getType() != Token::INTEGER) {
-					err << "Syntax Error: A line number must be an INTEGER!" << std::endl;
+				unsigned lineNumber;
+				if ((pTC->getType() != Token::INTEGER) || !::lineNumber(pTC->getValue(), lineNumber)) {
+					err << "Syntax Error: A line number must be an INTEGER up to " << MAX_LINE_NUMBER << '!' << std::endl;
 					err << line << std::endl;
-					return SYNTAX_ERROR;
+					return Error::SYNTAX_ERROR;
 				}
-				const unsigned lineNumber = std::stoul(pTC->getValue());
 				++itToken;
 
 				std::vector<Command> commands;
 				while (itToken != tokens.cend()) {
-					auto command = commandSlicer(itToken, tokens.cend());
+					auto command = commandSlicer(itToken, tokens.cend(), lineNumber);
+					const auto e = command.compile(runtime);
+					if (e) {
+						err << Error::message(e) << " in " << lineNumber << std::endl;
+						err << line << std::endl;
+						return e;
+					}
 					commands.push_back(command);
 				}
-				const auto success = program[lineNumber] = commands;
+				if (mode == LAZY) {
+					// The lines following are compiled with the types in force after this one.
+					if (!std::equal(std::begin(runtime.defaults), std::end(runtime.defaults), lazy.defaults.back().cbegin())) {
+						lazy.defaults.push_back(std::array<Token::type_t, 26>());
+						std::copy(std::begin(runtime.defaults), std::end(runtime.defaults), lazy.defaults.back().begin());
+					}
+				}
+				if (mode == OPTIMIZED) {
+					// LIST shows the source text, the tokens are no longer needed once compiled.
+					for (auto&& command : commands) command.strip();
+					for (auto&& token : tokens) delete token;
+					auto text = line.find_first_not_of(' ');
+					text = line.find_first_not_of("0123456789", text);
+					text = line.find_first_not_of(' ', text);
+					image->source[lineNumber] = text == std::string::npos ? "" : line.substr(text);
+				}
+				program[lineNumber] = commands;
 			}
-			return OK;
+			return Error::OK;
 		}
 
-		error_t list(const unsigned start=0, const unsigned stop=65535) const {
-			for (auto&& line : program) {
-				if ((line.first >= start) && (line.first <= stop))
-					out << std::setw(5) << line.first << ' ' << line.second << std::endl;
+		/**
+		 * Resolve the line numbers, once all lines are known.
+		 **/
+		void link() {
+			Program& program = image->program;
+			for (auto itLine = program.begin(); itLine != program.end(); ++itLine) {
+				for (unsigned i = 0; i < itLine->second.size(); ++i) {
+					const Position position = { itLine, i };
+					itLine->second[i].link(program, position);
+				}
 			}
-			return OK;
 		}
 
 		/**
-         * Run the current inmemory program.
-         * @param start Line to start from, dafault starts at the first line.
-         * @return the execussion code.
-         */
-        error_t run(const unsigned start=0) {
-			auto itLine = start ? program.find(start) : program.cbegin();
-            if (itLine == program.cend()) return LINE_NOT_FOUND;
+		 * Once the lines were edited: link them again and collect the DATA again. The run is cleared, it
+		 * cannot go on in a program changed.
+		 **/
+		void edited() {
+			link();
+			gatherData();
+			runtime.files.closeAll();
+			runtime.clear(image->program);
+		}
 
-			while (itLine != program.cend()) {
-				for (auto&& command: itLine->second) {
-					out << (&command == &(*itLine->second.cbegin()) ? "" : " : ") << command;
-				}
-				for (auto&& command: itLine->second) {
-					const auto err = command.execute();
-				}
-				out << std::endl;
-				++itLine;
-			}
-			return OK;
+		/**
+		 * True if the word appears in the line, in any case (even in a string or a comment).
+		 **/
+		static bool mentions(const std::string& aLine, const std::string& aWord) {
+			return std::search(aLine.cbegin(), aLine.cend(), aWord.cbegin(), aWord.cend(), [](const char a, const char b) {
+				return std::toupper(static_cast<unsigned char>(a)) == b;
+			}) != aLine.cend();
 		}
 
 		/**
-		 * Slice each tokens' list in separate commands, using ':' separator.
-		 * @param start Iterator on first token.
-		 * @param stop Iterator after the last token.
-		 * @return A vector of tokens.
+		 * Optimized load: drop the REM statements, and append each line which is never jumped to to the
+		 * preceding one, so that the program runs through long straight runs of commands.
+		 * The lines jumped to stay apart, as stubs leading to the following command when they hold nothing else.
+		 * RUN can then only start on the first line or on a line jumped to.
 		 **/
-		Command commandSlicer(std::vector<Token*>::const_iterator& start, const std::vector<Token*>::const_iterator& stop) {
-			std::vector<Token*> res;
-			for (auto itToken = start; itToken != stop; ++itToken) {
-				if (const auto pTSep = dynamic_cast<TokenSeparator*>(*itToken)) {
-					if(pTSep->getId() == ":") {
-						start = ++itToken;
-						return res;
-					}
+		void compact() {
+			Program& program = image->program;
+			std::set<unsigned> targets;
+			for (auto&& line : program) {
+				for (auto&& command : line.second) command.references(targets);
+			}
+
+			Program compacted;
+			std::vector<Command>* run = nullptr;
+			for (auto&& line : program) {
+				if (!run || targets.count(line.first)) run = &compacted[line.first];
+				for (auto&& command : line.second) {
+					if (!dynamic_cast<const StatementRem*>(command.getStatement())) run->push_back(command);
 				}
-				res.push_back(*itToken);
 			}
-			start = stop;
-			return Command(res);
+			program.swap(compacted);
 		}
 
-
 		/**
-		 * Return a string describing the current interpreter.
+		 * Return the memory available for the programs, as the platform reports it.
 		 **/
-		std::string toString() const {
+		unsigned long long freeBytes() const {
+#ifdef _WIN32
 			const auto handle = GetProcessHeap();
 			if (!handle) {
 				err << "Error getting process heap handle in" << __FILE__ << ':' << __LINE__ << ", func:" << __PRETTY_FUNCTION__ << std::endl;
@@ -167,26 +689,34 @@ class Interpreter {
 				err << "Error getting heap summary in" << __FILE__ << ':' << __LINE__ << ", func:" << __PRETTY_FUNCTION__ << std::endl;
 				exit(-1);
 			}
-
-
-			std::ostringstream s;
-			s << PRODUCT_NAME << ' ' << PRODUCT_VERSION << std::endl
-			  << "(C) Copyright M. SIBERT 2024" << std::endl
-			  << summary.cbReserved << " Bytes free" << std::endl
-			  << "Ok" << std::endl;
-
-			return s.str();
+			return summary.cbReserved;
+#else
+			return static_cast<unsigned long long>(sysconf(_SC_AVPHYS_PAGES)) * sysconf(_SC_PAGESIZE);
+#endif
 		}
 
-	protected:
-
-
 	private:
 		std::istream& in;
 		std::ostream& out;
 		std::ostream& err;
 
-		std::map<unsigned, std::vector<Command> > program;
+		///< State of the running program, symbols are bound to it when loading.
+		Runtime runtime;
+
+		///< How load() prepares the programs.
+		const mode_t mode;
+
+		///< Program in memory.
+		std::unique_ptr<Image> image;
+
+		///< Programs CHAINed from, compiled once, by file name.
+		std::map<std::string, std::unique_ptr<Image>> chained;
+
+		///< Commands executed by the last run.
+		unsigned long long statements = 0;
+
+		///< Published by the run for the other threads.
+		Metrics metrics;
 };
 
 std::ostream& operator<<(std::ostream& out, const Interpreter& aInterpreter) {
@@ -0,0 +1,46 @@
+/**
+ * Copyright [2024] Marc SIBERT
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#pragma once
+
+#include <cstddef>
+
+/**
+ * Heap usage of the calling thread, fed by the global operator new/delete defined in memstat.cpp.
+ * Each program of a batch runs in its own thread, so these counters are per program.
+ **/
+class MemStat {
+	public:
+		/**
+		 * Restart counting from now: current usage and peak are set back to 0.
+		 **/
+		static void reset();
+
+		/**
+		 * Bytes allocated and not yet freed since the last reset.
+		 **/
+		static long long current();
+
+		/**
+		 * Highest value reached by current() since the last reset.
+		 **/
+		static long long peak();
+
+		/**
+		 * Number of calls to operator new since the last reset.
+		 **/
+		static unsigned long long allocations();
+};
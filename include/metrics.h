@@ -0,0 +1,84 @@
+/**
+ * Copyright [2024] Marc SIBERT
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "expression.h"
+
+#ifndef METRICS
+///< Default: count the statements, expression operations and control stack depth while running, 0 compiles them out.
+#define METRICS 1
+#endif
+
+/**
+ * Counters of a running program, published by the thread running it and read from any other thread.
+ * The run keeps its counters in plain variables and publishes them every PERIOD statements and when it ends:
+ * the hot loop never writes to an atomic. With METRICS set to 0 only the end of each run publishes,
+ * without the operations and the control stack.
+ **/
+class Metrics {
+	public:
+		///< Number of expression opcodes counted.
+		static const unsigned OPCODES = Expression::COMPARE_STRING + 1;
+
+		///< Statements between two publications, a power of 2.
+		static const unsigned PERIOD = 4096;
+
+		/**
+		 * What is published, 64 bits words only.
+		 **/
+		struct Counters {
+			uint64_t statements;			///< Executed by the run.
+			uint64_t operations[OPCODES];	///< Expression operations executed, by opcode.
+			uint64_t allocations;			///< Calls to operator new of the thread.
+			uint64_t heapBytes;				///< Allocated and not freed yet by the thread.
+			uint64_t heapPeak;				///< Highest heapBytes.
+			uint64_t controlStackPeak;		///< Most frames of the control stack at a time.
+		};
+
+		Metrics() : sequence(0) {
+			for (auto&& word : words) word.store(0, std::memory_order_relaxed);
+		}
+
+		/**
+		 * Publish new values, from the thread running the program only.
+		 * Never waits: the readers retry if they overlap a publication.
+		 **/
+		void publish(const Counters& aCounters);
+
+		/**
+		 * A consistent copy of the last values published, from any thread, without any lock.
+		 **/
+		Counters snapshot() const;
+
+		/**
+		 * Write the counters of several programs in the Prometheus text format, each labelled with its file.
+		 **/
+		static void write(std::ostream& aOut, const std::vector<std::pair<std::string, Counters>>& aPrograms);
+
+	private:
+		static const unsigned WORDS = sizeof(Counters) / sizeof(uint64_t);
+
+		std::atomic<unsigned> sequence;		///< Odd while publishing.
+		std::atomic<uint64_t> words[WORDS];
+};
@@ -0,0 +1,173 @@
+/**
+ * Copyright [2024] Marc SIBERT
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "tokens.h"
+#include "expression.h"
+#include "program.h"
+
+class Runtime;
+
+/**
+ * Walk the tokens of a command while compiling it.
+ * Every parsing method returns false (or nullptr) on a syntax error, leaving the reason in getError().
+ **/
+class Parser {
+	public:
+		typedef std::vector<Token*>::const_iterator iterator;
+
+		Parser(const iterator& aStart, const iterator& aStop, Runtime& aRuntime);
+
+		/**
+		 * True after the last token of a statement: at the end of the command or on an ELSE.
+		 **/
+		bool atEnd() const;
+
+		/**
+		 * True after the last token of the command.
+		 **/
+		bool done() const {
+			return pos == stop;
+		}
+
+		/**
+		 * Current token, only when !done().
+		 **/
+		const Token* current() const {
+			return *pos;
+		}
+
+		void next() {
+			++pos;
+		}
+
+		/**
+		 * Skip all the remaining tokens.
+		 **/
+		void skip() {
+			pos = stop;
+		}
+
+		bool isInstruction(const char* aName) const;
+		bool isOperator(const char* aName) const;
+		bool isSeparator(const char* aName) const;
+
+		/**
+		 * Skip the current token if it is the instruction, operator or separator given.
+		 **/
+		bool acceptInstruction(const char* aName);
+		bool acceptOperator(const char* aName);
+		bool acceptSeparator(const char* aName);
+
+		/**
+		 * True on a channel constant, "#n".
+		 **/
+		bool isChannel() const;
+
+		/**
+		 * Skip the current token if it is an identifier spelling a word without suffix, like AS or RANDOM,
+		 * whatever its case.
+		 **/
+		bool acceptWord(const char* aWord);
+
+		/**
+		 * Parse and compile the number of a channel, "#n" or an INTEGER expression.
+		 **/
+		bool channel(Expression& aExpression);
+
+		/**
+		 * Parse a line number.
+		 **/
+		bool lineNumber(unsigned& aLine);
+
+		/**
+		 * Parse a line number, remembering its token for RENUM.
+		 **/
+		bool lineNumber(LineReference& aLine);
+
+		/**
+		 * Parse and compile an expression, of any type.
+		 **/
+		bool expression(Expression& aExpression);
+
+		/**
+		 * Parse and compile an expression converted to a type.
+		 * Fails with a TYPE_MISMATCH between a STRING and a number.
+		 **/
+		bool expression(Expression& aExpression, const Token::type_t aType);
+
+		/**
+		 * Parse a variable or an array element.
+		 **/
+		bool lvalue(Lvalue& aLvalue);
+
+		/**
+		 * Parse an identifier, returning its name in upper case and its type.
+		 * The name always ends with the suffix of the type, the one given by DEFINT, DEFSNG, DEFDBL or DEFSTR
+		 * for a name without suffix: "A" and "A!" are the same variable.
+		 **/
+		bool identifier(std::string& aName, Token::type_t& aType);
+
+		Runtime& getRuntime() {
+			return runtime;
+		}
+
+		Error::error_t getError() const {
+			return error;
+		}
+
+		/**
+		 * Record an error other than SYNTAX_ERROR, returning false for convenience.
+		 **/
+		bool fail(const Error::error_t aError) {
+			error = aError;
+			return false;
+		}
+
+	private:
+		/**
+		 * Compile the operators of a precedence level, from IMP (0) to ^ (12).
+		 * @param aType Type of the value compiled.
+		 **/
+		bool binary(Expression& aExpression, const unsigned aLevel, Token::type_t& aType);
+
+		/**
+		 * Compile a constant, variable, array element, function call or parenthesis.
+		 **/
+		bool primary(Expression& aExpression, Token::type_t& aType);
+
+		/**
+		 * Compile the operation specialized for the types of its operands, converting them first if needed.
+		 * @param aCode The INTEGER variant of the operation (SINGLE for / and ^).
+		 * @param aLeft Type of the left operand, then of the result.
+		 **/
+		bool operation(Expression& aExpression, const Expression::opcode_t aCode, const unsigned aArg, Token::type_t& aLeft, const Token::type_t aRight);
+
+		/**
+		 * Compile the conversion of the value aOffset places below the top of the stack (1 for the top).
+		 * Fails with a TYPE_MISMATCH between a STRING and a number.
+		 **/
+		bool convert(Expression& aExpression, const Token::type_t aFrom, const Token::type_t aTo, const unsigned aOffset);
+
+		iterator pos;
+		const iterator stop;
+		Runtime& runtime;
+		Error::error_t error;
+};
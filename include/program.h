@@ -0,0 +1,117 @@
+/**
+ * Copyright [2024] Marc SIBERT
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#pragma once
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+class Command;
+class Token;
+
+/**
+ * The program in memory: the commands of each line, by line number.
+ **/
+typedef std::map<unsigned, std::vector<Command> > Program;
+
+///< Highest line number, as in GW-BASIC.
+const unsigned MAX_LINE_NUMBER = 65529;
+
+/**
+ * Parse the digits of a line number, any number of them without overflowing.
+ * @return false if there is no digit, something else than digits, or a number above MAX_LINE_NUMBER.
+ **/
+inline bool lineNumber(const std::string& aDigits, unsigned& aNumber)
+{
+	if (aDigits.empty()) return false;
+	aNumber = 0;
+	for (auto c : aDigits) {
+		if ((c < '0') || (c > '9')) return false;
+		aNumber = aNumber * 10 + (c - '0');
+		if (aNumber > MAX_LINE_NUMBER) return false;
+	}
+	return true;
+}
+
+/**
+ * New number of each line RENUM moves, by old number, in the order of the lines.
+ **/
+typedef std::vector<std::pair<unsigned, unsigned> > Renumbering;
+
+/**
+ * Find the new number of a line.
+ * @return false if RENUM does not move the line.
+ **/
+inline bool renumbered(const Renumbering& aNumbers, const unsigned aLine, unsigned& aNumber)
+{
+	const auto it = std::lower_bound(aNumbers.cbegin(), aNumbers.cend(), std::make_pair(aLine, 0u));
+	if ((it == aNumbers.cend()) || (it->first != aLine)) return false;
+	aNumber = it->second;
+	return true;
+}
+
+/**
+ * Position of a command in the program.
+ **/
+struct Position {
+	Program::const_iterator line;
+	unsigned index;			///< Command in the line.
+
+	/**
+	 * Move to the following command, skipping the lines without any.
+	 **/
+	void next(const Program& aProgram);
+
+	/**
+	 * Skip the lines without any command, from the current one.
+	 **/
+	void settle(const Program& aProgram);
+
+	/**
+	 * Line number of the command, which is not always line->first once the optimized load fused the lines.
+	 **/
+	unsigned number() const;
+};
+
+/**
+ * A line number written in a statement, resolved to a position once the whole program is loaded:
+ * jumping to it does not search the program.
+ **/
+struct LineReference {
+	LineReference(const unsigned aLine = 0) : line(aLine), resolved(false), token(nullptr) {}
+
+	/**
+	 * Find the first command of the line, or of the following one if the line has none.
+	 * The reference stays unresolved if there is no such line.
+	 **/
+	void resolve(const Program& aProgram);
+
+	/**
+	 * Add the line to aLines, if any.
+	 **/
+	void reference(std::set<unsigned>& aLines) const {
+		if (line) aLines.insert(line);
+	}
+
+	unsigned line;			///< As written, 0 for none.
+	Position position;		///< Only when resolved.
+	bool resolved;
+	const Token* token;		///< Constant the line is written with, which RENUM replaces, nullptr if none.
+};
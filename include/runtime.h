@@ -0,0 +1,228 @@
+/**
+ * Copyright [2024] Marc SIBERT
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "command.h"
+#include "controlstack.h"
+#include "files.h"
+#include "value.h"
+
+#ifndef ARRAY_ELEMENTS
+///< Most elements of an array, above which it is out of memory.
+#define ARRAY_ELEMENTS 16777216
+#endif
+
+/**
+ * An array, with the upper bound of each dimension (lower bound is always 0).
+ **/
+struct Array {
+	Token::type_t type;
+	std::vector<unsigned> bounds;	///< Empty until dimensioned.
+	std::vector<Value> values;
+};
+
+/**
+ * Program requested by CHAIN, which the interpreter loads once the current one is stopped.
+ **/
+struct ChainRequest {
+	ChainRequest() : line(0), all(false) {}
+
+	std::string file;			///< Empty if none.
+	unsigned line;				///< To start from, 0 for the first one.
+	bool all;					///< Pass all the variables, not only the COMMON ones.
+};
+
+/**
+ * Everything a running program works on: variables, arrays, stacks, DATA and the console.
+ * Symbols (variable and array names) are given their slot while compiling, so that execution only uses indexes.
+ **/
+class Runtime {
+	public:
+		/**
+		 * @param aDepth Frames of the control stack, allocated once here.
+		 **/
+		Runtime(std::istream& aIn, std::ostream& aOut, std::ostream& aErr, const unsigned aDepth = CONTROL_STACK_DEPTH);
+
+		/**
+		 * Return the slot of a variable, creating it if needed.
+		 * @param aName Name in upper case, type suffix included.
+		 **/
+		unsigned variable(const std::string& aName, const Token::type_t aType);
+
+		/**
+		 * Return the slot of an array, creating it if needed.
+		 **/
+		unsigned array(const std::string& aName, const Token::type_t aType);
+
+		/**
+		 * Make sure the evaluation stack can hold aDepth values (only called while compiling).
+		 **/
+		void reserve(const unsigned aDepth);
+
+		/**
+		 * Forget every symbol, for a new program.
+		 **/
+		void reset();
+
+		/**
+		 * Start a run of the program: values back to zero, arrays erased, stacks emptied and DATA restored.
+		 **/
+		void clear(const Program& aProgram);
+
+		/**
+		 * Write the state of the run in a snapshot: variables, arrays, control stack, next command,
+		 * error trapping and DATA pointer. The open files are not part of it.
+		 **/
+		void save(std::ostream& aOut) const;
+
+		/**
+		 * Read the state of the run from a snapshot, once the same program is loaded and cleared.
+		 * @return BAD_FILE_MODE if the snapshot is corrupted or does not match the program.
+		 **/
+		Error::error_t restore(std::istream& aIn);
+
+		/**
+		 * Write the variables and arrays by name, the dimensioned arrays only.
+		 * @param aVariables, aArrays Slots of the ones written, all of them if nullptr.
+		 **/
+		void saveVariables(std::ostream& aOut, const std::set<unsigned>* aVariables = nullptr, const std::set<unsigned>* aArrays = nullptr) const;
+
+		/**
+		 * Read the variables and arrays by name, creating the ones the program has not compiled yet.
+		 **/
+		Error::error_t restoreVariables(std::istream& aIn);
+
+		/**
+		 * Continue execution at the first command of a line.
+		 * @return LINE_NOT_FOUND if there is no such line.
+		 **/
+		Error::error_t jump(const unsigned aLine);
+
+		/**
+		 * Continue execution at a line resolved when loading.
+		 * @return LINE_NOT_FOUND if there is no such line.
+		 **/
+		Error::error_t jump(const LineReference& aLine) {
+			if (!aLine.resolved) return Error::LINE_NOT_FOUND;
+			pc = aLine.position;
+			return Error::OK;
+		}
+
+		/**
+		 * Branch to the ON ERROR GOTO handler, only called once an error is raised.
+		 * @return false if there is no handler, or if the error was raised in the handler.
+		 **/
+		bool trap(const Error::error_t aError);
+
+		/**
+		 * Move pc to the following command.
+		 **/
+		void advance() {
+			pc.next(*program);
+		}
+
+		/**
+		 * Stop the program, like END.
+		 **/
+		void end() {
+			pc.line = program->cend();
+			pc.index = 0;
+		}
+
+		/**
+		 * Dimension an array.
+		 * @return DUPLICATE_DEFINITION if already dimensioned, OUT_OF_MEMORY above ARRAY_ELEMENTS elements.
+		 **/
+		Error::error_t dimension(const unsigned aArray, const std::vector<unsigned>& aBounds);
+
+		/**
+		 * Return an element of an array, dimensioning it to 10 on first use as in GW-BASIC.
+		 **/
+		Error::error_t element(const unsigned aArray, const int16_t* aIndexes, const unsigned aCount, Value*& aElement);
+
+		/**
+		 * Write on the console, keeping track of the column.
+		 **/
+		void print(const std::string& aText) {
+			print(aText.data(), aText.size());
+		}
+
+		/**
+		 * Write characters on the console, keeping track of the column.
+		 **/
+		void print(const char* aText, const std::size_t aSize);
+
+		/**
+		 * End the current console line.
+		 **/
+		void newline() {
+			*output << '\n';
+			column = 0;
+		}
+
+		/**
+		 * Next pseudo random number in [0, 1[, reproducible from the seed.
+		 **/
+		float random();
+
+		std::istream& in;
+		std::ostream& out;
+		std::ostream& err;
+		std::ostream* output;			///< Of print() and newline(): out, or a file during PRINT #.
+
+		const Program* program;
+		Position pc;					///< Next command to execute.
+		Position current;				///< Command being executed.
+		Position stopped;				///< Command following the last STOP, to continue from, at the end if none.
+
+		Token::type_t defaults[26];		///< Type of the variables without suffix, by initial (DEFINT, DEFSNG...).
+
+		std::vector<Value> variables;
+		std::vector<Array> arrays;
+		std::vector<Value> stack;		///< Evaluation stack of the expressions.
+		uint64_t operations[Metrics::OPCODES];	///< Expression operations executed, by opcode, if METRICS.
+
+		ControlStack control;			///< Active GOSUB, FOR and WHILE.
+
+		LineReference errorHandler;		///< Line of ON ERROR GOTO, 0 if none.
+		bool handlingError;				///< Running the handler, until RESUME.
+		Error::error_t lastError;		///< ERR
+		unsigned errorLine;				///< ERL
+		Position errorPosition;			///< Command which raised the error, for RESUME.
+
+		std::vector<Value> data;		///< All DATA items of the program, in order.
+		std::map<unsigned, unsigned> dataLines;		///< First item of each DATA line.
+		unsigned dataPointer;			///< Next item READ.
+
+		Files files;					///< Channels of OPEN, #1 to #FILE_CHANNELS.
+		ChainRequest chain;				///< Set by CHAIN.
+
+		unsigned column;				///< Console column, 0 based.
+		uint32_t seed;					///< RND generator state.
+		float lastRandom;
+
+	private:
+		std::map<std::string, unsigned> variableSlots;
+		std::map<std::string, unsigned> arraySlots;
+};
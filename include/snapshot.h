@@ -0,0 +1,52 @@
+/**
+ * Copyright [2024] Marc SIBERT
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+
+#include "program.h"
+#include "value.h"
+
+/**
+ * Binary encoding of the snapshots of a run: little endian integers, strings after their length,
+ * and floating values in the format of the machine.
+ * A position is the line number with the rank of the command in the line, REM left out, so that it
+ * is found again whatever the mode the program is reloaded in.
+ **/
+class Snapshot {
+	public:
+		static void put(std::ostream& aOut, const uint32_t aValue);
+		static void put(std::ostream& aOut, const std::string& aString);
+		static void put(std::ostream& aOut, const Value& aValue);
+		static void put(std::ostream& aOut, const Program& aProgram, const Position& aPosition);
+
+		/**
+		 * Read what put() wrote.
+		 * @return false on a truncated or corrupted snapshot.
+		 **/
+		static bool get(std::istream& aIn, uint32_t& aValue);
+		static bool get(std::istream& aIn, std::string& aString);
+		static bool get(std::istream& aIn, Value& aValue);
+
+		/**
+		 * Read a position, compiling its line first if it was loaded lazily.
+		 **/
+		static bool get(std::istream& aIn, const Program& aProgram, Position& aPosition);
+};
@@ -0,0 +1,702 @@
+/**
+ * Copyright [2024] Marc SIBERT
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "errors.h"
+#include "expression.h"
+#include "files.h"
+#include "format.h"
+#include "program.h"
+
+class Runtime;
+class Parser;
+
+/**
+ * A statement compiled from the tokens of a command.
+ **/
+class Statement {
+	public:
+		virtual ~Statement() {}
+
+		/**
+		 * Factory compiling the statement at the parser position, or returning a nullptr on error.
+		 **/
+		static Statement* create(Parser& aParser);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const = 0;
+
+		/**
+		 * Resolve the line numbers and the positions the statement jumps to, once the whole program is loaded.
+		 * @param aPosition Position of the statement in aProgram.
+		 **/
+		virtual void link(const Program&, const Position&) {}
+
+		/**
+		 * Add the line numbers the statement jumps to, the lines which the optimized load keeps apart.
+		 **/
+		virtual void references(std::set<unsigned>&) const {}
+
+		/**
+		 * Add the line references of the statement, for RENUM to renumber them.
+		 **/
+		virtual void lineReferences(std::vector<LineReference*>&) {}
+};
+
+/**
+ * StatementRem, also used for empty commands.
+ */
+class StatementRem : public Statement {
+	public:
+		static StatementRem* create(Parser& aParser);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+};
+
+/**
+ * StatementUnsupported, for instructions tokenized but not implemented: fails when executed, not when loaded.
+ */
+class StatementUnsupported : public Statement {
+	public:
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+};
+
+/**
+ * Source text of a program loaded lazily, from which its lines are compiled when first needed.
+ **/
+struct LazySource {
+	LazySource(Runtime& aRuntime, Program& aProgram) : runtime(aRuntime), program(aProgram) {}
+
+	/**
+	 * Compile a line not compiled yet in place of its StatementLazy, then link its commands.
+	 * @param aLine A line of program, left as it is if already compiled.
+	 * @return The error found compiling, the StatementLazy then stays to report it when run.
+	 **/
+	Error::error_t expand(const Program::const_iterator& aLine);
+
+	Runtime& runtime;			///< Binding the symbols of the lines compiled.
+	Program& program;			///< Holding the lines.
+	std::string text;			///< Text of the lines following their number, end to end.
+	std::vector<std::array<Token::type_t, 26> > defaults;	///< Types given by DEFINT, DEFSNG... along the file.
+};
+
+/**
+ * StatementLazy: the only command of a line not compiled yet, compiling it when first executed.
+ */
+class StatementLazy : public Statement {
+	public:
+		/**
+		 * @param aOffset Text of the line in aSource.text.
+		 * @param aDefaults Types of the variables without suffix at this line, in aSource.defaults.
+		 **/
+		StatementLazy(LazySource& aSource, const unsigned aOffset, const unsigned aLength, const unsigned aDefaults) :
+			source(aSource), offset(aOffset), length(aLength), defaults(aDefaults) {}
+
+		/**
+		 * @return UNCOMPILED, for the interpreter to expand the line from its source then run it.
+		 **/
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+
+		/**
+		 * Compile the text of the line, leaving the program as it is.
+		 * @param aLine Number of the line.
+		 **/
+		Error::error_t compile(const unsigned aLine, std::vector<Command>& aCommands) const;
+
+		LazySource& getSource() const {
+			return source;
+		}
+
+		/**
+		 * Text of the line following its number.
+		 **/
+		std::string getText() const {
+			return source.text.substr(offset, length);
+		}
+
+		/**
+		 * Write the text of the line following its number.
+		 **/
+		void list(std::ostream& out) const {
+			out.write(source.text.data() + offset, length);
+		}
+
+		/**
+		 * RENUM without compiling the line: its text with the line numbers following GOTO, GOSUB, THEN, ELSE,
+		 * RESTORE, RESUME and RETURN renumbered, the strings and comments left as they are.
+		 * @return false if the line references none of the lines moved, aText then being left empty.
+		 **/
+		bool renumber(const Renumbering& aNumbers, std::string& aText) const;
+
+		unsigned getDefaults() const {
+			return defaults;
+		}
+
+	private:
+		LazySource& source;
+		unsigned offset;
+		unsigned length;
+		unsigned defaults;
+};
+
+/**
+ * StatementLet, with or without LET.
+ */
+class StatementLet : public Statement {
+	public:
+		static StatementLet* create(Parser& aParser);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+
+	private:
+		Lvalue target;
+		Expression value;
+};
+
+/**
+ * StatementPrint, on the console or PRINT # on a sequential file, PRINT USING through a format.
+ */
+class StatementPrint : public Statement {
+	public:
+		static StatementPrint* create(Parser& aParser);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+
+	private:
+		struct Item {
+			enum { EXPRESSION, TAB, SPC, NONE } kind;
+			Expression expression;
+			char separator;		///< ';', ',' or 0 after the item.
+		};
+
+		/**
+		 * Print the items on the output of the runtime.
+		 **/
+		Error::error_t print(Runtime& aRuntime) const;
+
+		/**
+		 * PRINT USING: print the items through the format, compiling it again only if its text changed.
+		 **/
+		Error::error_t printUsing(Runtime& aRuntime) const;
+
+		Expression channel;			///< Empty for the console.
+		std::vector<Item> items;
+
+		bool formatted;						///< PRINT USING.
+		Expression formatExpression;		///< Empty when the format is a literal, compiled when parsing.
+		mutable Format format;
+		mutable std::string formatText;		///< Text format was compiled from, for a computed format.
+		mutable Error::error_t formatError;	///< Of compiling format.
+};
+
+/**
+ * StatementInput, from the console or INPUT # from a sequential file, and LINE INPUT [#].
+ */
+class StatementInput : public Statement {
+	public:
+		static StatementInput* create(Parser& aParser, const bool aLine);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+
+	private:
+		/**
+		 * INPUT #: read the items separated by commas or line ends, a string may be quoted.
+		 **/
+		Error::error_t read(Runtime& aRuntime, File& aFile) const;
+
+		Expression channel;			///< Empty for the console.
+		std::string prompt;
+		bool question;				///< Print "? " after the prompt.
+		bool line;					///< LINE INPUT: the whole line, up to its end, into a single string.
+		std::vector<Lvalue> targets;
+};
+
+/**
+ * StatementIf: IF ... THEN|GOTO ... [ELSE ...]
+ */
+class StatementIf : public Statement {
+	public:
+		static StatementIf* create(Parser& aParser);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+
+		virtual void link(const Program& aProgram, const Position& aPosition);
+
+		virtual void references(std::set<unsigned>& aLines) const;
+
+		virtual void lineReferences(std::vector<LineReference*>& aLines);
+
+	private:
+		/**
+		 * Parse a branch: a line number or a statement.
+		 **/
+		static bool branch(Parser& aParser, LineReference& aLine, std::unique_ptr<Statement>& aStatement);
+
+		Expression condition;
+		LineReference thenLine;		///< No line if thenStatement is used.
+		std::unique_ptr<Statement> thenStatement;
+		LineReference elseLine;
+		std::unique_ptr<Statement> elseStatement;
+		Position endOfLine;			///< First command of the next line, where to go when the condition is false.
+};
+
+/**
+ * StatementGoto
+ */
+class StatementGoto : public Statement {
+	public:
+		static StatementGoto* create(Parser& aParser);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+
+		virtual void link(const Program& aProgram, const Position& aPosition);
+
+		virtual void references(std::set<unsigned>& aLines) const;
+
+		virtual void lineReferences(std::vector<LineReference*>& aLines);
+
+	private:
+		LineReference line;
+};
+
+/**
+ * StatementGosub
+ */
+class StatementGosub : public Statement {
+	public:
+		static StatementGosub* create(Parser& aParser);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+
+		virtual void link(const Program& aProgram, const Position& aPosition);
+
+		virtual void references(std::set<unsigned>& aLines) const;
+
+		virtual void lineReferences(std::vector<LineReference*>& aLines);
+
+	private:
+		LineReference line;
+};
+
+/**
+ * StatementReturn
+ */
+class StatementReturn : public Statement {
+	public:
+		static StatementReturn* create(Parser& aParser);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+
+		virtual void link(const Program& aProgram, const Position& aPosition);
+
+		virtual void references(std::set<unsigned>& aLines) const;
+
+		virtual void lineReferences(std::vector<LineReference*>& aLines);
+
+	private:
+		LineReference line;			///< No line to return after the GOSUB.
+};
+
+/**
+ * StatementOn: ON n GOTO|GOSUB line, line...
+ * The lines are a jump table resolved when loading, indexed in constant time.
+ */
+class StatementOn : public Statement {
+	public:
+		static StatementOn* create(Parser& aParser);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+
+		virtual void link(const Program& aProgram, const Position& aPosition);
+
+		virtual void references(std::set<unsigned>& aLines) const;
+
+		virtual void lineReferences(std::vector<LineReference*>& aLines);
+
+	private:
+		Expression selector;
+		bool gosub;
+		std::vector<LineReference> lines;
+};
+
+/**
+ * StatementOnError: ON ERROR GOTO line, 0 to disable the handler.
+ */
+class StatementOnError : public Statement {
+	public:
+		static StatementOnError* create(Parser& aParser);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+
+		virtual void link(const Program& aProgram, const Position& aPosition);
+
+		virtual void references(std::set<unsigned>& aLines) const;
+
+		virtual void lineReferences(std::vector<LineReference*>& aLines);
+
+	private:
+		LineReference line;
+};
+
+/**
+ * StatementResume: RESUME [0|NEXT|line]
+ */
+class StatementResume : public Statement {
+	public:
+		static StatementResume* create(Parser& aParser);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+
+		virtual void link(const Program& aProgram, const Position& aPosition);
+
+		virtual void references(std::set<unsigned>& aLines) const;
+
+		virtual void lineReferences(std::vector<LineReference*>& aLines);
+
+	private:
+		bool next;					///< RESUME NEXT.
+		LineReference line;			///< No line to retry the command which failed.
+};
+
+/**
+ * StatementError: ERROR n, raising the error n.
+ */
+class StatementError : public Statement {
+	public:
+		static StatementError* create(Parser& aParser);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+
+	private:
+		Expression code;
+};
+
+/**
+ * StatementFor
+ */
+class StatementFor : public Statement {
+	public:
+		static StatementFor* create(Parser& aParser);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+
+		/**
+		 * Find the command following the matching NEXT, where to go when the loop is not run.
+		 **/
+		virtual void link(const Program& aProgram, const Position& aPosition);
+
+		unsigned getVariable() const {
+			return variable;
+		}
+
+	private:
+		unsigned variable;
+		Expression from;
+		Expression to;
+		Expression step;			///< Empty for STEP 1.
+		Position exit;				///< Command following the matching NEXT.
+		bool linked;				///< False if there is no matching NEXT.
+};
+
+/**
+ * StatementNext
+ */
+class StatementNext : public Statement {
+	public:
+		static StatementNext* create(Parser& aParser);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+
+		const std::vector<unsigned>& getVariables() const {
+			return variables;
+		}
+
+	private:
+		std::vector<unsigned> variables;	///< Empty for the innermost loop.
+};
+
+/**
+ * StatementWhile
+ */
+class StatementWhile : public Statement {
+	public:
+		static StatementWhile* create(Parser& aParser);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+
+		/**
+		 * Find the command following the matching WEND, where to go when the condition is false.
+		 **/
+		virtual void link(const Program& aProgram, const Position& aPosition);
+
+	private:
+		Expression condition;
+		Position exit;				///< Command following the matching WEND.
+		bool linked;				///< False if there is no matching WEND.
+};
+
+/**
+ * StatementWend
+ */
+class StatementWend : public Statement {
+	public:
+		static StatementWend* create(Parser& aParser);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+};
+
+/**
+ * StatementDim
+ */
+class StatementDim : public Statement {
+	public:
+		static StatementDim* create(Parser& aParser);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+
+	private:
+		struct Declaration {
+			unsigned array;
+			std::vector<Expression> bounds;
+		};
+
+		std::vector<Declaration> declarations;
+};
+
+/**
+ * StatementEnd
+ */
+class StatementEnd : public Statement {
+	public:
+		static StatementEnd* create(Parser& aParser);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+};
+
+/**
+ * StatementStop
+ */
+class StatementStop : public Statement {
+	public:
+		static StatementStop* create(Parser& aParser);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+};
+
+/**
+ * StatementData: nothing to do at run time, the items are gathered by the interpreter when loading.
+ */
+class StatementData : public Statement {
+	public:
+		static StatementData* create(Parser& aParser);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+
+		/**
+		 * Items of the statement. A numeric item keeps its source text in Value::string, for READ in a string.
+		 **/
+		const std::vector<Value>& getValues() const {
+			return values;
+		}
+
+	private:
+		std::vector<Value> values;
+};
+
+/**
+ * StatementRead
+ */
+class StatementRead : public Statement {
+	public:
+		static StatementRead* create(Parser& aParser);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+
+	private:
+		std::vector<Lvalue> targets;
+};
+
+/**
+ * StatementRestore
+ */
+class StatementRestore : public Statement {
+	public:
+		static StatementRestore* create(Parser& aParser);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+
+		virtual void references(std::set<unsigned>& aLines) const;
+
+		virtual void lineReferences(std::vector<LineReference*>& aLines);
+
+	private:
+		LineReference line;			///< No line for the first DATA.
+};
+
+/**
+ * StatementRandomize
+ */
+class StatementRandomize : public Statement {
+	public:
+		static StatementRandomize* create(Parser& aParser);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+
+	private:
+		Expression seed;
+};
+
+/**
+ * StatementDeftype: DEFINT, DEFSNG, DEFDBL and DEFSTR.
+ * Types are decided when compiling, so these statements apply to the lines following them in the file,
+ * and do nothing at run time.
+ */
+class StatementDeftype : public Statement {
+	public:
+		static StatementDeftype* create(Parser& aParser, const Token::type_t aType);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+
+	private:
+		/**
+		 * Parse a single letter, in upper case.
+		 **/
+		static bool letter(Parser& aParser, char& aLetter);
+};
+
+/**
+ * StatementOpen: OPEN f$ [FOR INPUT|OUTPUT|APPEND|RANDOM] AS [#]n [LEN = l], or OPEN m$, [#]n, f$ [, l].
+ */
+class StatementOpen : public Statement {
+	public:
+		static StatementOpen* create(Parser& aParser);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+
+	private:
+		Expression name;
+		Expression modeName;		///< "I", "O", "A" or "R", only in the second form.
+		File::mode_t mode;
+		Expression channel;
+		Expression length;			///< Of a record, 128 if empty.
+};
+
+/**
+ * StatementClose: CLOSE [[#]n [, [#]n]...], all the files without channel.
+ */
+class StatementClose : public Statement {
+	public:
+		static StatementClose* create(Parser& aParser);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+
+	private:
+		std::vector<Expression> channels;
+};
+
+/**
+ * StatementField: FIELD [#]n, w AS v$ [, w AS v$]...
+ * The variables receive their bytes of the record at each GET and give them back at each PUT.
+ */
+class StatementField : public Statement {
+	public:
+		static StatementField* create(Parser& aParser);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+
+	private:
+		struct Item {
+			Expression width;
+			unsigned variable;
+		};
+
+		Expression channel;
+		std::vector<Item> items;
+};
+
+/**
+ * StatementGet: GET and PUT [#]n [, r], reading or writing a record of a random file, the next one without r.
+ */
+class StatementGet : public Statement {
+	public:
+		static StatementGet* create(Parser& aParser, const bool aPut);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+
+	private:
+		bool put;
+		Expression channel;
+		Expression record;
+};
+
+/**
+ * StatementLset: LSET and RSET v$ = x$, justifying a string in the current length of the variable.
+ */
+class StatementLset : public Statement {
+	public:
+		static StatementLset* create(Parser& aParser, const bool aRight);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+
+	private:
+		bool right;
+		Lvalue target;
+		Expression value;
+};
+
+/**
+ * StatementChain: CHAIN f$ [, [line] [, ALL]], which the interpreter carries out once the program is stopped.
+ */
+class StatementChain : public Statement {
+	public:
+		static StatementChain* create(Parser& aParser);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+
+	private:
+		Expression file;
+		unsigned line;				///< 0 for the first line.
+		bool all;
+};
+
+/**
+ * StatementCommon: COMMON v [, a()]..., the variables and arrays passed by CHAIN. Nothing to do when executed.
+ */
+class StatementCommon : public Statement {
+	public:
+		static StatementCommon* create(Parser& aParser);
+
+		virtual Error::error_t execute(Runtime& aRuntime) const;
+
+		const std::set<unsigned>& getVariables() const {
+			return variables;
+		}
+
+		const std::set<unsigned>& getArrays() const {
+			return arrays;
+		}
+
+	private:
+		std::set<unsigned> variables;
+		std::set<unsigned> arrays;
+};
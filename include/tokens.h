@@ -18,6 +18,7 @@
 
 #include <ostream>
 #include <string>
+#include <vector>
 #include <regex>
 #include <list>
 
@@ -27,8 +28,18 @@ class Token {
 		///< To distinguish between String or Number identifier (with $ terminator).
 		enum type_t { STRING, INTEGER, SINGLE, DOUBLE, HEXADECIMAL, OCTAL, CHANEL };
 
+		///< How the token is spaced when listed: SIGN is an operator which may be a sign, OPEN and CLOSE are parenthesis.
+		enum spacing_t { WORD, FUNCTION, KEYWORD, OPERATOR, SIGN, OPEN, CLOSE, SEPARATOR };
+
+		virtual ~Token() {}
+
+		virtual spacing_t getSpacing() const = 0;
+
 	protected:
-		virtual std::string toString() const = 0;
+		/**
+		 * Write the token as listed, straight into the stream, without any space around it.
+		 **/
+		virtual void print(std::ostream& out) const = 0;
 
 		friend std::ostream& operator<<(std::ostream&, const Token&);
 };
@@ -52,8 +63,12 @@ class TokenComment : public Token {
 		 */
 		static TokenComment* create(std::string::const_iterator& aStart, const std::string::const_iterator& aStop);
 
+		virtual spacing_t getSpacing() const {
+			return KEYWORD;
+		}
+
 	protected:
-		virtual std::string toString() const;
+		virtual void print(std::ostream& out) const;
 
 	private:
 ///< Comment content.
@@ -82,15 +97,19 @@ class TokenInstruction : public Token {
 
 		const std::string& getString() const;
 
+		virtual spacing_t getSpacing() const {
+			return KEYWORD;
+		}
+
 	protected:
-		virtual std::string toString() const;
+		virtual void print(std::ostream& out) const;
 
 	private:
 		///< Token id.
 		const unsigned id;
 
 		///< List of all tokens allowed for instructions.
-		static const std::string tokens[99];
+		static const std::string tokens[104];
 };
 
 /**
@@ -108,15 +127,25 @@ class TokenFunction : public Token {
 		 */
 		static TokenFunction* create(std::string::const_iterator& aStart, const std::string::const_iterator& aStop);
 
+		unsigned getId() const {
+			return id;
+		}
+
+		const std::string& getString() const;
+
+		virtual spacing_t getSpacing() const {
+			return FUNCTION;
+		}
+
 	protected:
-		virtual std::string toString() const;
+		virtual void print(std::ostream& out) const;
 
 	private:
 		///< Token id.
 		const unsigned id;
 
 		///< List of all tokens allowed for function.
-		static const std::string tokens[0];
+		static const std::string tokens[42];
 };
 
 /**
@@ -136,10 +165,22 @@ class TokenIdentifier : public Token {
 
 		const std::string& getName() const;
 
+		/**
+		 * Type given by the suffix ($, %, ! or #), SINGLE without suffix.
+		 */
 		const type_t& getType() const;
 
+		/**
+		 * True if the type is given by a suffix, false if it depends on DEFINT, DEFSNG, DEFDBL and DEFSTR.
+		 */
+		bool hasSuffix() const;
+
+		virtual spacing_t getSpacing() const {
+			return WORD;
+		}
+
 	protected:
-		virtual std::string toString() const;
+		virtual void print(std::ostream& out) const;
 
 	private:
 		const std::string name;
@@ -161,11 +202,18 @@ class TokenOperator : public Token {
 		 */
 		static TokenOperator* create(std::string::const_iterator& aStart, const std::string::const_iterator& aStop);
 
+		const std::string& getId() const;
+
+		virtual spacing_t getSpacing() const {
+			return spacing;
+		}
+
 	protected:
-		virtual std::string toString() const;
+		virtual void print(std::ostream& out) const;
 
 	private:
 		const std::string id;
+		const spacing_t spacing;	///< Decided once, LIST asks for it on every token.
 };
 
 /**
@@ -193,8 +241,12 @@ class TokenConstant : public Token {
 		 */
 		const std::string& getValue() const;
 
+		virtual spacing_t getSpacing() const {
+			return WORD;
+		}
+
 	protected:
-		virtual std::string toString() const;
+		virtual void print(std::ostream& out) const;
 
 	private:
 		const std::string value;
@@ -218,8 +270,12 @@ class TokenSeparator : public Token {
 
 		const std::string& getId() const;
 
+		virtual spacing_t getSpacing() const {
+			return SEPARATOR;
+		}
+
 	protected:
-		virtual std::string toString() const;
+		virtual void print(std::ostream& out) const;
 
 	private:
 		const std::string id;
@@ -231,4 +287,8 @@ class TokenSeparator : public Token {
  */
 std::ostream& operator<<(std::ostream&, const Token&);
 
-std::ostream& operator<<(std::ostream&, const std::vector<Token*>);
+/**
+ * List the tokens of a command, spaced in a canonical way: around the keywords and the binary operators,
+ * after the commas and semicolons, and nowhere else.
+ */
+std::ostream& operator<<(std::ostream&, const std::vector<Token*>&);
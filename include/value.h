@@ -0,0 +1,97 @@
+/**
+ * Copyright [2024] Marc SIBERT
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "tokens.h"
+#include "errors.h"
+
+/**
+ * A BASIC value: an INTEGER (16 bits), a SINGLE, a DOUBLE or a STRING.
+ **/
+class Value {
+	public:
+		Value() : type(Token::SINGLE), single(0) {}
+		Value(const int16_t aInteger) : type(Token::INTEGER), integer(aInteger) {}
+		Value(const float aSingle) : type(Token::SINGLE), single(aSingle) {}
+		Value(const double aDouble) : type(Token::DOUBLE), dbl(aDouble) {}
+		Value(const std::string& aString) : type(Token::STRING), dbl(0), string(aString) {}
+
+		/**
+		 * Factory building the value of a constant token.
+		 * INTEGER constants out of the 16 bits range become SINGLE, as in GW-BASIC.
+		 **/
+		static Error::error_t create(const TokenConstant& aToken, Value& aValue);
+
+		/**
+		 * Factory parsing a number the way VAL does: leading spaces are skipped and parsing stops
+		 * on the first unexpected character.
+		 **/
+		static Value parse(const std::string& aText);
+
+		/**
+		 * Return the zero (or empty string) of a type.
+		 **/
+		static Value zero(const Token::type_t aType);
+
+		bool isString() const {
+			return type == Token::STRING;
+		}
+
+		/**
+		 * Return the numeric value as a double (0 for a string).
+		 **/
+		double toDouble() const {
+			switch (type) {
+				case Token::INTEGER : return integer;
+				case Token::SINGLE : return single;
+				case Token::DOUBLE : return dbl;
+				default : return 0;
+			}
+		}
+
+		/**
+		 * Round the numeric value to an INTEGER, like CINT.
+		 * @return OVERFLOW_ERROR out of -32768..32767, TYPE_MISMATCH for a string.
+		 **/
+		Error::error_t toInteger(int16_t& aInteger) const;
+
+		/**
+		 * Convert the value in place to a numeric type.
+		 **/
+		Error::error_t convert(const Token::type_t aType);
+
+		/**
+		 * Store a value in this one, converted to the type of this one (the type of a variable never changes).
+		 **/
+		Error::error_t assign(const Value& aValue);
+
+		/**
+		 * Format the value like PRINT does: numbers have a leading space or minus sign, no trailing space.
+		 **/
+		std::string toString() const;
+
+		Token::type_t type;			///< INTEGER, SINGLE, DOUBLE or STRING.
+		union {
+			int16_t integer;
+			float single;
+			double dbl;
+		};
+		std::string string;			///< Only meaningful for a STRING.
+};
@@ -0,0 +1,71 @@
+/**
+ * Copyright [2024] Marc SIBERT
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include "command.h"
+#include "parser.h"
+
+#include <algorithm>
+#include <string>
+
+Error::error_t Command::compile(Runtime& aRuntime)
+{
+	Parser parser(cbegin(), cend(), aRuntime);
+	Statement* s = Statement::create(parser);
+	if (s && !parser.done()) {
+		// An ELSE left over, not part of an IF.
+		delete s;
+		s = nullptr;
+	}
+	if (!s) return parser.getError();
+	statement.reset(s);
+	return Error::OK;
+}
+
+Command Command::slice(std::vector<Token*>::const_iterator& aStart, const std::vector<Token*>::const_iterator& aStop, const unsigned aLine)
+{
+	std::vector<Token*> tokens;
+	for (auto itToken = aStart; itToken != aStop; ++itToken) {
+		if (const auto pTSep = dynamic_cast<TokenSeparator*>(*itToken)) {
+			if (pTSep->getId() == ":") {
+				aStart = ++itToken;
+				return Command(tokens, aLine);
+			}
+		}
+		tokens.push_back(*itToken);
+	}
+	aStart = aStop;
+	return Command(tokens, aLine);
+}
+
+void Command::renumber(const unsigned aLine, const Renumbering& aNumbers)
+{
+	line = aLine;
+
+	std::vector<LineReference*> references;
+	if (statement) statement->lineReferences(references);
+	for (auto&& reference : references) {
+		unsigned number;
+		if (!reference->line || !renumbered(aNumbers, reference->line, number)) continue;
+
+		reference->line = number;
+		if (!reference->token) continue;
+		// The token only belongs to this command, listed with the new number from now on.
+		Token* const token = new TokenConstant(std::to_string(number), Token::INTEGER);
+		std::replace(begin(), end(), const_cast<Token*>(reference->token), token);
+		delete reference->token;
+		reference->token = token;
+	}
+}
@@ -0,0 +1,52 @@
+/**
+ * Copyright [2024] Marc SIBERT
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include "errors.h"
+
+const char* Error::message(const error_t aError)
+{
+	switch (aError) {
+		case OK : return "Ok";
+		case NEXT_WITHOUT_FOR : return "NEXT without FOR";
+		case SYNTAX_ERROR : return "Syntax error";
+		case RETURN_WITHOUT_GOSUB : return "RETURN without GOSUB";
+		case OUT_OF_DATA : return "Out of DATA";
+		case ILLEGAL_FUNCTION_CALL : return "Illegal function call";
+		case OVERFLOW_ERROR : return "Overflow";
+		case OUT_OF_MEMORY : return "Out of memory";
+		case LINE_NOT_FOUND : return "Undefined line number";
+		case SUBSCRIPT_OUT_OF_RANGE : return "Subscript out of range";
+		case DUPLICATE_DEFINITION : return "Duplicate Definition";
+		case DIVISION_BY_ZERO : return "Division by zero";
+		case TYPE_MISMATCH : return "Type mismatch";
+		case STRING_TOO_LONG : return "String too long";
+		case RESUME_WITHOUT_ERROR : return "RESUME without error";
+		case FOR_WITHOUT_NEXT : return "FOR without NEXT";
+		case WHILE_WITHOUT_WEND : return "WHILE without WEND";
+		case WEND_WITHOUT_WHILE : return "WEND without WHILE";
+		case FIELD_OVERFLOW : return "FIELD overflow";
+		case BAD_FILE_NUMBER : return "Bad file number";
+		case FILE_NOT_FOUND : return "File not found";
+		case BAD_FILE_MODE : return "Bad file mode";
+		case FILE_ALREADY_OPEN : return "File already open";
+		case DEVICE_IO_ERROR : return "Device I/O Error";
+		case INPUT_PAST_END : return "Input past end";
+		case BAD_RECORD_NUMBER : return "Bad record number";
+		case ADVANCED_FEATURE : return "Advanced feature";
+		case UNCOMPILED : return "Line not compiled";
+	}
+	return "Unprintable error";
+}
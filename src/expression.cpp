@@ -0,0 +1,660 @@
+/**
+ * Copyright [2024] Marc SIBERT
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include "expression.h"
+#include "runtime.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+void setInteger(Value& aValue, const long aInteger)
+{
+	aValue.type = Token::INTEGER;
+	aValue.integer = static_cast<int16_t>(aInteger);
+}
+
+void setSingle(Value& aValue, const float aSingle)
+{
+	aValue.type = Token::SINGLE;
+	aValue.single = aSingle;
+}
+
+void setDouble(Value& aValue, const double aDouble)
+{
+	aValue.type = Token::DOUBLE;
+	aValue.dbl = aDouble;
+}
+
+void setString(Value& aValue, const std::string& aString)
+{
+	aValue.type = Token::STRING;
+	aValue.string = aString;
+}
+
+/**
+ * Set a floating result, SINGLE unless aDouble, checking for overflow.
+ **/
+Error::error_t setFloat(Value& aValue, const double aResult, const bool aDouble)
+{
+	if (aDouble) {
+		if (std::isinf(aResult)) return Error::OVERFLOW_ERROR;
+		setDouble(aValue, aResult);
+	} else {
+		const float f = static_cast<float>(aResult);
+		if (std::isinf(f)) return Error::OVERFLOW_ERROR;
+		setSingle(aValue, f);
+	}
+	return Error::OK;
+}
+
+/**
+ * Store an INTEGER result, checking for overflow.
+ **/
+inline Error::error_t checkedInteger(int16_t& aResult, const long aValue)
+{
+	if ((aValue < -32768) || (aValue > 32767)) return Error::OVERFLOW_ERROR;
+	aResult = static_cast<int16_t>(aValue);
+	return Error::OK;
+}
+
+/**
+ * Store a SINGLE or DOUBLE result, checking for overflow.
+ **/
+template<typename T> inline Error::error_t checkedFloat(T& aResult, const T aValue)
+{
+	aResult = aValue;
+	return std::isinf(aValue) ? Error::OVERFLOW_ERROR : Error::OK;
+}
+
+/**
+ * -1, 0 or 1 when a is lower, equal or greater than b.
+ **/
+template<typename T> inline int compare(const T a, const T b)
+{
+	return (a > b) - (a < b);
+}
+
+/**
+ * Result of each relation_t, for a lower, equal or greater first operand.
+ **/
+const int16_t relations[][3] = {
+	{ 0, -1, 0 },		// EQUAL
+	{ -1, 0, -1 },		// NOT_EQUAL
+	{ -1, 0, 0 },		// LESS
+	{ 0, 0, -1 },		// GREATER
+	{ -1, -1, 0 },		// LESS_EQUAL
+	{ 0, -1, -1 }		// GREATER_EQUAL
+};
+
+inline void relation(Value& aValue, const unsigned aRelation, const int aCompare)
+{
+	aValue.type = Token::INTEGER;
+	aValue.integer = relations[aRelation][aCompare + 1];
+}
+
+/**
+ * Power, SINGLE or DOUBLE.
+ **/
+template<typename T> inline Error::error_t power(T& x, const T y)
+{
+	if ((x == 0) && (y < 0)) return Error::DIVISION_BY_ZERO;
+	if ((x < 0) && (y != std::floor(y))) return Error::ILLEGAL_FUNCTION_CALL;
+	return checkedFloat(x, static_cast<T>(std::pow(x, y)));
+}
+
+/**
+ * Read an argument as an integer in [aMin, aMax].
+ **/
+Error::error_t argument(const Value& aValue, const int aMin, const int aMax, int& aResult)
+{
+	if (aValue.isString()) return Error::TYPE_MISMATCH;
+	const double d = std::floor(aValue.toDouble() + 0.5);
+	if ((d < aMin) || (d > aMax)) return (d < -32768 || d > 65535) ? Error::OVERFLOW_ERROR : Error::ILLEGAL_FUNCTION_CALL;
+	aResult = static_cast<int>(d);
+	return Error::OK;
+}
+
+/**
+ * MKI$, MKS$ and MKD$: the bytes of a number, in the byte order and floating format of the machine.
+ **/
+template<typename T> Error::error_t pack(Value& aValue, const T aNumber)
+{
+	aValue.type = Token::STRING;
+	aValue.string.assign(reinterpret_cast<const char*>(&aNumber), sizeof(T));
+	return Error::OK;
+}
+
+/**
+ * CVI, CVS and CVD: the number whose bytes MKI$, MKS$ or MKD$ returned.
+ **/
+template<typename T> Error::error_t unpack(Value& aValue)
+{
+	if (aValue.string.size() < sizeof(T)) return Error::ILLEGAL_FUNCTION_CALL;
+	T number;
+	std::memcpy(&number, aValue.string.data(), sizeof(T));
+	aValue = Value(number);
+	return Error::OK;
+}
+
+/**
+ * Call a function, its arguments are in aArgs[0..aCount[ and its result goes in aArgs[0].
+ **/
+Error::error_t call(const Expression::function_t aFunction, Value* aArgs, const unsigned aCount, Runtime& aRuntime)
+{
+	Value& r = aArgs[0];
+	int n = 0, m = 0;
+	Error::error_t error = Error::OK;
+
+	// The types of the arguments are checked by the parser.
+	switch (aFunction) {
+		case Expression::ABS :
+			if (r.type == Token::INTEGER) {
+				if (r.integer == -32768) return Error::OVERFLOW_ERROR;
+				r.integer = std::abs(r.integer);
+			} else if (r.type == Token::SINGLE) r.single = std::fabs(r.single);
+			else r.dbl = std::fabs(r.dbl);
+			return Error::OK;
+		case Expression::ASC :
+			if (r.string.empty()) return Error::ILLEGAL_FUNCTION_CALL;
+			setInteger(r, static_cast<unsigned char>(r.string[0]));
+			return Error::OK;
+		case Expression::ATN : return setFloat(r, std::atan(r.toDouble()), r.type == Token::DOUBLE);
+		case Expression::CDBL : return r.convert(Token::DOUBLE);
+		case Expression::CHR :
+			error = argument(r, 0, 255, n);
+			if (!error) setString(r, std::string(1, static_cast<char>(n)));
+			return error;
+		case Expression::CINT : return r.convert(Token::INTEGER);
+		case Expression::COS : return setFloat(r, std::cos(r.toDouble()), r.type == Token::DOUBLE);
+		case Expression::CSNG : return r.convert(Token::SINGLE);
+		case Expression::CVD : return unpack<double>(r);
+		case Expression::CVI : return unpack<int16_t>(r);
+		case Expression::CVS : return unpack<float>(r);
+		case Expression::END_OF_FILE :
+		case Expression::LOC :
+		case Expression::LOF : {
+			error = argument(r, 0, 255, n);
+			File* f;
+			if (!error) error = aRuntime.files.get(n, f);
+			if (error) return error;
+			if (aFunction == Expression::END_OF_FILE) {
+				if ((f->mode == File::OUTPUT) || (f->mode == File::APPEND)) return Error::BAD_FILE_MODE;
+				setInteger(r, (f->mode == File::RANDOM ? f->end : f->stream.peek() == std::char_traits<char>::eof()) ? -1 : 0);
+			} else if (f->mode == File::RANDOM) {
+				setSingle(r, aFunction == Expression::LOC ? f->record : f->size);
+			} else {
+				// Sequential files count in blocks of 128 bytes, as in GW-BASIC. EOF may have set the end of file state.
+				f->stream.clear();
+				const double position = f->mode == File::INPUT ? static_cast<double>(f->stream.tellg()) : static_cast<double>(f->stream.tellp());
+				setSingle(r, aFunction == Expression::LOC ? std::floor(position / 128) : (f->mode == File::INPUT ? f->size : position));
+			}
+			return Error::OK;
+		}
+		case Expression::ERL :
+			setSingle(r, aRuntime.errorLine);		// Up to 65529, more than an INTEGER.
+			return Error::OK;
+		case Expression::ERR :
+			setInteger(r, aRuntime.lastError);
+			return Error::OK;
+		case Expression::EXP : return setFloat(r, std::exp(r.toDouble()), r.type == Token::DOUBLE);
+		case Expression::FIX :
+			if (r.type == Token::SINGLE) r.single = std::trunc(r.single);
+			else if (r.type == Token::DOUBLE) r.dbl = std::trunc(r.dbl);
+			return Error::OK;
+		case Expression::HEX :
+		case Expression::OCT : {
+			error = argument(r, -32768, 65535, n);
+			if (error) return error;
+			char buffer[8];
+			snprintf(buffer, sizeof(buffer), aFunction == Expression::HEX ? "%X" : "%o", static_cast<unsigned>(n & 0xFFFF));
+			setString(r, buffer);
+			return Error::OK;
+		}
+		case Expression::INSTR : {
+			unsigned first = 0;
+			if (aCount == 3) {
+				error = argument(aArgs[0], 1, 255, n);
+				if (error) return error;
+				first = 1;
+			} else n = 1;
+			if (!aArgs[first].isString() || !aArgs[first + 1].isString()) return Error::TYPE_MISMATCH;
+			const std::string& s = aArgs[first].string;
+			const auto p = (static_cast<unsigned>(n) > s.size()) ? std::string::npos : s.find(aArgs[first + 1].string, n - 1);
+			setInteger(r, p == std::string::npos ? 0 : p + 1);
+			return Error::OK;
+		}
+		case Expression::INT :
+			if (r.type == Token::SINGLE) r.single = std::floor(r.single);
+			else if (r.type == Token::DOUBLE) r.dbl = std::floor(r.dbl);
+			return Error::OK;
+		case Expression::LEFT :
+		case Expression::RIGHT :
+			error = argument(aArgs[1], 0, 255, n);
+			if (error) return error;
+			if (static_cast<unsigned>(n) < r.string.size()) {
+				if (aFunction == Expression::LEFT) r.string.resize(n);
+				else r.string.erase(0, r.string.size() - n);
+			}
+			return Error::OK;
+		case Expression::LEN :
+			setInteger(r, r.string.size());
+			return Error::OK;
+		case Expression::LOG :
+			if (r.toDouble() <= 0) return Error::ILLEGAL_FUNCTION_CALL;
+			return setFloat(r, std::log(r.toDouble()), r.type == Token::DOUBLE);
+		case Expression::MID :
+			error = argument(aArgs[1], 1, 255, n);
+			if (!error && (aCount == 3)) error = argument(aArgs[2], 0, 255, m);
+			else m = 255;
+			if (error) return error;
+			if (static_cast<unsigned>(n) > r.string.size()) r.string.clear();
+			else r.string = r.string.substr(n - 1, m);
+			return Error::OK;
+		case Expression::MKD : return pack(r, r.toDouble());
+		case Expression::MKI : {
+			int16_t i;
+			error = r.toInteger(i);
+			if (!error) pack(r, i);
+			return error;
+		}
+		case Expression::MKS : {
+			const float f = static_cast<float>(r.toDouble());
+			if (std::isinf(f)) return Error::OVERFLOW_ERROR;
+			return pack(r, f);
+		}
+		case Expression::POS :
+			setInteger(r, aRuntime.column + 1);
+			return Error::OK;
+		case Expression::RND : {
+			const double x = aCount ? r.toDouble() : 1;
+			if (x < 0) {
+				const float f = static_cast<float>(x);
+				uint32_t bits;
+				std::memcpy(&bits, &f, sizeof(bits));
+				aRuntime.seed = bits;
+			}
+			setSingle(r, x == 0 ? aRuntime.lastRandom : aRuntime.random());
+			return Error::OK;
+		}
+		case Expression::SGN : {
+			const double d = r.toDouble();
+			setInteger(r, d > 0 ? 1 : (d < 0 ? -1 : 0));
+			return Error::OK;
+		}
+		case Expression::SIN : return setFloat(r, std::sin(r.toDouble()), r.type == Token::DOUBLE);
+		case Expression::SPACE :
+			error = argument(r, 0, 255, n);
+			if (!error) setString(r, std::string(n, ' '));
+			return error;
+		case Expression::SQR :
+			if (r.toDouble() < 0) return Error::ILLEGAL_FUNCTION_CALL;
+			return setFloat(r, std::sqrt(r.toDouble()), r.type == Token::DOUBLE);
+		case Expression::STR :
+			setString(r, r.toString());
+			return Error::OK;
+		case Expression::STRING : {
+			error = argument(aArgs[0], 0, 255, n);
+			if (error) return error;
+			if (aArgs[1].isString()) {
+				if (aArgs[1].string.empty()) return Error::ILLEGAL_FUNCTION_CALL;
+				m = static_cast<unsigned char>(aArgs[1].string[0]);
+			} else {
+				error = argument(aArgs[1], 0, 255, m);
+				if (error) return error;
+			}
+			setString(r, std::string(n, static_cast<char>(m)));
+			return Error::OK;
+		}
+		case Expression::TAN : return setFloat(r, std::tan(r.toDouble()), r.type == Token::DOUBLE);
+		case Expression::VAL :
+			// SINGLE, whatever the text, for the result to have a static type.
+			r = Value::parse(r.string);
+			return r.convert(Token::SINGLE);
+		default :	// SPC and TAB only make sense in PRINT.
+			return Error::ILLEGAL_FUNCTION_CALL;
+	}
+}
+
+}
+
+bool Expression::function(const std::string& aName, function_t& aFunction, unsigned& aMin, unsigned& aMax, const char*& aSignature)
+{
+	static const struct {
+		const char* name;
+		function_t function;
+		unsigned min, max;
+		const char* signature;
+	} functions[] = {
+		{ "ABS", ABS, 1, 1, "=N" }, { "ASC", ASC, 1, 1, "%$" }, { "ATN", ATN, 1, 1, "~N" },
+		{ "CDBL", CDBL, 1, 1, "#N" }, { "CHR$", CHR, 1, 1, "$N" }, { "CINT", CINT, 1, 1, "%N" }, { "COS", COS, 1, 1, "~N" }, { "CSNG", CSNG, 1, 1, "!N" },
+		{ "CVD", CVD, 1, 1, "#$" }, { "CVI", CVI, 1, 1, "%$" }, { "CVS", CVS, 1, 1, "!$" },
+		{ "EOF", END_OF_FILE, 1, 1, "%N" }, { "ERL", ERL, 0, 0, "!" }, { "ERR", ERR, 0, 0, "%" }, { "EXP", EXP, 1, 1, "~N" },
+		{ "FIX", FIX, 1, 1, "=N" },
+		{ "HEX$", HEX, 1, 1, "$N" },
+		{ "INSTR", INSTR, 2, 3, "%N$$" }, { "INT", INT, 1, 1, "=N" },
+		{ "LEFT$", LEFT, 2, 2, "$$N" }, { "LEN", LEN, 1, 1, "%$" }, { "LOC", LOC, 1, 1, "!N" }, { "LOF", LOF, 1, 1, "!N" }, { "LOG", LOG, 1, 1, "~N" },
+		{ "MID$", MID, 2, 3, "$$NN" }, { "MKD$", MKD, 1, 1, "$N" }, { "MKI$", MKI, 1, 1, "$N" }, { "MKS$", MKS, 1, 1, "$N" },
+		{ "OCT$", OCT, 1, 1, "$N" },
+		{ "POS", POS, 1, 1, "%*" },
+		{ "RIGHT$", RIGHT, 2, 2, "$$N" }, { "RND", RND, 0, 1, "!N" },
+		{ "SGN", SGN, 1, 1, "%N" }, { "SIN", SIN, 1, 1, "~N" }, { "SPACE$", SPACE, 1, 1, "$N" }, { "SPC", SPC, 1, 1, "$N" }, { "SQR", SQR, 1, 1, "~N" },
+		{ "STR$", STR, 1, 1, "$N" }, { "STRING$", STRING, 2, 2, "$N*" },
+		{ "TAB", TAB, 1, 1, "$N" }, { "TAN", TAN, 1, 1, "~N" },
+		{ "VAL", VAL, 1, 1, "!$" }
+	};
+
+	for (auto&& f : functions) {
+		if (aName == f.name) {
+			aFunction = f.function;
+			aMin = f.min;
+			aMax = f.max;
+			aSignature = f.signature;
+			return true;
+		}
+	}
+	return false;
+}
+
+void Expression::emit(const opcode_t aCode, const unsigned aArg, const unsigned aCount)
+{
+	const Operation op = { aCode, aArg, aCount };
+	operations.push_back(op);
+
+	switch (aCode) {
+		case PUSH_CONSTANT :
+		case PUSH_STRING_CONSTANT :
+		case PUSH_VARIABLE :
+		case PUSH_STRING_VARIABLE :
+			++depth;
+			break;
+		case PUSH_ELEMENT :
+		case CALL :
+			depth = depth - aCount + 1;
+			break;
+		case INTEGER_TO_SINGLE :
+		case INTEGER_TO_DOUBLE :
+		case SINGLE_TO_INTEGER :
+		case SINGLE_TO_DOUBLE :
+		case DOUBLE_TO_INTEGER :
+		case DOUBLE_TO_SINGLE :
+		case NEGATE_INTEGER :
+		case NEGATE_SINGLE :
+		case NEGATE_DOUBLE :
+		case NOT :
+			break;
+		default :
+			--depth;
+	}
+	if (depth > maxDepth) maxDepth = depth;
+}
+
+Error::error_t Expression::run(Runtime& aRuntime, Value*& aTop) const
+{
+	Value* sp = aRuntime.stack.data();	// Next free slot.
+	Error::error_t error = Error::OK;
+
+	for (auto&& op : operations) {
+#if METRICS
+		++aRuntime.operations[op.code];
+#endif
+		switch (op.code) {
+			case PUSH_CONSTANT :
+				sp->type = constants[op.arg].type;
+				sp->dbl = constants[op.arg].dbl;		// copies the whole union.
+				++sp;
+				break;
+			case PUSH_STRING_CONSTANT :
+				sp->type = Token::STRING;
+				sp->string = constants[op.arg].string;
+				++sp;
+				break;
+			case PUSH_VARIABLE :
+				sp->type = aRuntime.variables[op.arg].type;
+				sp->dbl = aRuntime.variables[op.arg].dbl;
+				++sp;
+				break;
+			case PUSH_STRING_VARIABLE :
+				sp->type = Token::STRING;
+				sp->string = aRuntime.variables[op.arg].string;
+				++sp;
+				break;
+			case PUSH_ELEMENT : {
+				sp -= op.count;
+				int16_t indexes[MAX_DIMENSIONS];
+				for (unsigned i = 0; i < op.count; ++i) indexes[i] = sp[i].integer;
+				Value* element = nullptr;
+				error = aRuntime.element(op.arg, indexes, op.count, element);
+				if (error) return error;
+				sp->type = element->type;
+				if (element->isString()) sp->string = element->string;
+				else sp->dbl = element->dbl;
+				++sp;
+				break;
+			}
+			case CALL :
+				sp -= op.count;
+				if (!op.count) *sp = Value();
+				error = call(static_cast<function_t>(op.arg), sp, op.count, aRuntime);
+				++sp;
+				break;
+
+			case INTEGER_TO_SINGLE : {
+				Value& v = sp[-static_cast<int>(op.arg)];
+				v.single = v.integer;
+				v.type = Token::SINGLE;
+				break;
+			}
+			case INTEGER_TO_DOUBLE : {
+				Value& v = sp[-static_cast<int>(op.arg)];
+				v.dbl = v.integer;
+				v.type = Token::DOUBLE;
+				break;
+			}
+			case SINGLE_TO_INTEGER :
+			case DOUBLE_TO_INTEGER : {
+				Value& v = sp[-static_cast<int>(op.arg)];
+				int16_t i;
+				error = v.toInteger(i);
+				v.integer = i;
+				v.type = Token::INTEGER;
+				break;
+			}
+			case SINGLE_TO_DOUBLE : {
+				Value& v = sp[-static_cast<int>(op.arg)];
+				v.dbl = v.single;
+				v.type = Token::DOUBLE;
+				break;
+			}
+			case DOUBLE_TO_SINGLE : {
+				Value& v = sp[-static_cast<int>(op.arg)];
+				v.type = Token::SINGLE;
+				error = checkedFloat(v.single, static_cast<float>(v.dbl));
+				break;
+			}
+
+			case NEGATE_INTEGER :
+				error = checkedInteger(sp[-1].integer, -long(sp[-1].integer));
+				break;
+			case NEGATE_SINGLE :
+				sp[-1].single = -sp[-1].single;
+				break;
+			case NEGATE_DOUBLE :
+				sp[-1].dbl = -sp[-1].dbl;
+				break;
+			case NOT :
+				sp[-1].integer = ~sp[-1].integer;
+				break;
+
+			case ADD_INTEGER :
+				--sp;
+				error = checkedInteger(sp[-1].integer, long(sp[-1].integer) + sp->integer);
+				break;
+			case ADD_SINGLE :
+				--sp;
+				error = checkedFloat(sp[-1].single, sp[-1].single + sp->single);
+				break;
+			case ADD_DOUBLE :
+				--sp;
+				error = checkedFloat(sp[-1].dbl, sp[-1].dbl + sp->dbl);
+				break;
+			case CONCAT :
+				--sp;
+				if (sp[-1].string.size() + sp->string.size() > 255) return Error::STRING_TOO_LONG;
+				sp[-1].string += sp->string;
+				break;
+			case SUBTRACT_INTEGER :
+				--sp;
+				error = checkedInteger(sp[-1].integer, long(sp[-1].integer) - sp->integer);
+				break;
+			case SUBTRACT_SINGLE :
+				--sp;
+				error = checkedFloat(sp[-1].single, sp[-1].single - sp->single);
+				break;
+			case SUBTRACT_DOUBLE :
+				--sp;
+				error = checkedFloat(sp[-1].dbl, sp[-1].dbl - sp->dbl);
+				break;
+			case MULTIPLY_INTEGER :
+				--sp;
+				error = checkedInteger(sp[-1].integer, long(sp[-1].integer) * sp->integer);
+				break;
+			case MULTIPLY_SINGLE :
+				--sp;
+				error = checkedFloat(sp[-1].single, sp[-1].single * sp->single);
+				break;
+			case MULTIPLY_DOUBLE :
+				--sp;
+				error = checkedFloat(sp[-1].dbl, sp[-1].dbl * sp->dbl);
+				break;
+			case DIVIDE_SINGLE :
+				--sp;
+				if (sp->single == 0) return Error::DIVISION_BY_ZERO;
+				error = checkedFloat(sp[-1].single, sp[-1].single / sp->single);
+				break;
+			case DIVIDE_DOUBLE :
+				--sp;
+				if (sp->dbl == 0) return Error::DIVISION_BY_ZERO;
+				error = checkedFloat(sp[-1].dbl, sp[-1].dbl / sp->dbl);
+				break;
+			case POWER_SINGLE :
+				--sp;
+				error = power(sp[-1].single, sp->single);
+				break;
+			case POWER_DOUBLE :
+				--sp;
+				error = power(sp[-1].dbl, sp->dbl);
+				break;
+
+			case INTEGER_DIVIDE :
+				--sp;
+				if (!sp->integer) return Error::DIVISION_BY_ZERO;
+				error = checkedInteger(sp[-1].integer, long(sp[-1].integer) / sp->integer);
+				break;
+			case MODULO :
+				--sp;
+				if (!sp->integer) return Error::DIVISION_BY_ZERO;
+				sp[-1].integer = (sp->integer == -1) ? 0 : sp[-1].integer % sp->integer;
+				break;
+			case AND :
+				--sp;
+				sp[-1].integer &= sp->integer;
+				break;
+			case OR :
+				--sp;
+				sp[-1].integer |= sp->integer;
+				break;
+			case XOR :
+				--sp;
+				sp[-1].integer ^= sp->integer;
+				break;
+			case EQV :
+				--sp;
+				sp[-1].integer = ~(sp[-1].integer ^ sp->integer);
+				break;
+			case IMP :
+				--sp;
+				sp[-1].integer = ~sp[-1].integer | sp->integer;
+				break;
+
+			case COMPARE_INTEGER :
+				--sp;
+				relation(sp[-1], op.arg, compare(sp[-1].integer, sp->integer));
+				break;
+			case COMPARE_SINGLE :
+				--sp;
+				relation(sp[-1], op.arg, compare(sp[-1].single, sp->single));
+				break;
+			case COMPARE_DOUBLE :
+				--sp;
+				relation(sp[-1], op.arg, compare(sp[-1].dbl, sp->dbl));
+				break;
+			case COMPARE_STRING :
+				--sp;
+				relation(sp[-1], op.arg, compare(sp[-1].string.compare(sp->string), 0));
+				break;
+		}
+		if (error) return error;
+	}
+
+	aTop = sp - 1;
+	return Error::OK;
+}
+
+Error::error_t Expression::evaluate(Runtime& aRuntime, Value& aResult) const
+{
+	Value* top = nullptr;
+	const auto error = run(aRuntime, top);
+	if (error) return error;
+	std::swap(aResult, *top);
+	return Error::OK;
+}
+
+Error::error_t Expression::evaluate(Runtime& aRuntime, int16_t& aResult) const
+{
+	Value* top = nullptr;
+	const auto error = run(aRuntime, top);
+	if (error) return error;
+	aResult = top->integer;
+	return Error::OK;
+}
+
+Error::error_t Lvalue::resolve(Runtime& aRuntime, Value*& aValue) const
+{
+	if (!array) {
+		aValue = &aRuntime.variables[slot];
+		return Error::OK;
+	}
+
+	int16_t values[Expression::MAX_DIMENSIONS];
+	for (unsigned i = 0; i < indexes.size(); ++i) {
+		const auto error = indexes[i].evaluate(aRuntime, values[i]);
+		if (error) return error;
+	}
+	return aRuntime.element(slot, values, indexes.size(), aValue);
+}
+
+Error::error_t Lvalue::assign(Runtime& aRuntime, const Value& aValue) const
+{
+	Value* target = nullptr;
+	const auto error = resolve(aRuntime, target);
+	if (error) return error;
+	return target->assign(aValue);
+}
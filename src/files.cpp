@@ -0,0 +1,257 @@
+/**
+ * Copyright [2024] Marc SIBERT
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include "files.h"
+
+#include <algorithm>
+#include <cstring>
+
+Error::error_t BlockCache::read(File& aFile, const unsigned long aPosition, char* aData, const unsigned long aSize)
+{
+	return span(aFile, aPosition, aSize, false, [&aData](const char* aBlock, const unsigned long aBytes) {
+		std::memcpy(aData, aBlock, aBytes);
+		aData += aBytes;
+	});
+}
+
+Error::error_t BlockCache::write(File& aFile, const unsigned long aPosition, const char* aData, const unsigned long aSize)
+{
+	return span(aFile, aPosition, aSize, true, [&aData](char* aBlock, const unsigned long aBytes) {
+		std::memcpy(aBlock, aData, aBytes);
+		aData += aBytes;
+	});
+}
+
+Error::error_t BlockCache::fill(File& aFile, const unsigned long aPosition, const char aChar, const unsigned long aSize)
+{
+	return span(aFile, aPosition, aSize, true, [aChar](char* aBlock, const unsigned long aBytes) {
+		std::memset(aBlock, aChar, aBytes);
+	});
+}
+
+Error::error_t BlockCache::flush(File& aFile)
+{
+	Error::error_t result = Error::OK;
+	for (auto& b : blocks) {
+		if (b.file != &aFile) continue;
+		if (b.dirty) {
+			const auto error = writeBack(b);
+			if (error) result = error;
+		}
+		b.file = nullptr;
+		b.used = 0;
+	}
+	last = nullptr;
+
+	// Records PUT without a field up to their end may still be short on disk.
+	aFile.stream.clear();
+	aFile.stream.seekp(0, std::ios::end);
+	if (static_cast<unsigned long>(aFile.stream.tellp()) < aFile.size) {
+		aFile.stream.seekp(aFile.size - 1);
+		aFile.stream.put(0);
+	}
+	aFile.stream.flush();
+	return aFile.stream ? result : Error::DEVICE_IO_ERROR;
+}
+
+template<class F> Error::error_t BlockCache::span(File& aFile, unsigned long aPosition, unsigned long aSize, const bool aWrite, F aCopy)
+{
+	if (aWrite) aFile.size = std::max(aFile.size, aPosition + aSize);
+	while (aSize) {
+		Block* block;
+		const auto error = fetch(aFile, aPosition / FILE_BLOCK_SIZE, block);
+		if (error) return error;
+
+		const unsigned offset = aPosition % FILE_BLOCK_SIZE;
+		const unsigned long bytes = std::min<unsigned long>(aSize, FILE_BLOCK_SIZE - offset);
+		aCopy(block->data + offset, bytes);
+		block->dirty = block->dirty || aWrite;
+		aPosition += bytes;
+		aSize -= bytes;
+	}
+	return Error::OK;
+}
+
+Error::error_t BlockCache::fetch(File& aFile, const unsigned long aNumber, Block*& aBlock)
+{
+	++clock;
+	if (last && (last->file == &aFile) && (last->number == aNumber)) {
+		last->used = clock;
+		aBlock = last;
+		return Error::OK;
+	}
+
+	if (blocks.empty()) {
+		storage.resize(static_cast<std::size_t>(count) * FILE_BLOCK_SIZE);
+		blocks.resize(count);
+		for (unsigned i = 0; i < count; ++i) blocks[i] = Block{ nullptr, 0, 0, false, &storage[static_cast<std::size_t>(i) * FILE_BLOCK_SIZE] };
+	}
+
+	Block* victim = &blocks[0];
+	for (auto& b : blocks) {
+		if ((b.file == &aFile) && (b.number == aNumber)) {
+			b.used = clock;
+			aBlock = last = &b;
+			return Error::OK;
+		}
+		if (b.used < victim->used) victim = &b;
+	}
+
+	if (victim->dirty) {
+		const auto error = writeBack(*victim);
+		if (error) return error;
+	}
+
+	// Only the bytes the file has on disk are read, the blocks PUT past its end are not there yet.
+	const unsigned long start = aNumber * FILE_BLOCK_SIZE;
+	std::streamsize bytes = 0;
+	if (start < aFile.size) {
+		aFile.stream.clear();
+		aFile.stream.seekg(start);
+		aFile.stream.read(victim->data, FILE_BLOCK_SIZE);
+		bytes = aFile.stream.gcount();
+		aFile.stream.clear();
+	}
+	std::memset(victim->data + bytes, 0, FILE_BLOCK_SIZE - bytes);
+
+	victim->file = &aFile;
+	victim->number = aNumber;
+	victim->used = clock;
+	victim->dirty = false;
+	aBlock = last = victim;
+	return Error::OK;
+}
+
+Error::error_t BlockCache::writeBack(Block& aBlock)
+{
+	File& f = *aBlock.file;
+	const unsigned long start = aBlock.number * FILE_BLOCK_SIZE;
+	aBlock.dirty = false;
+	if (start >= f.size) return Error::OK;
+
+	f.stream.clear();
+	f.stream.seekp(start);
+	f.stream.write(aBlock.data, std::min<unsigned long>(FILE_BLOCK_SIZE, f.size - start));
+	return f.stream ? Error::OK : Error::DEVICE_IO_ERROR;
+}
+
+
+Error::error_t Files::open(const int aChannel, const std::string& aName, const File::mode_t aMode, const int aLength)
+{
+	if ((aChannel < 1) || (aChannel > FILE_CHANNELS)) return Error::BAD_FILE_NUMBER;
+	if (channels[aChannel - 1]) return Error::FILE_ALREADY_OPEN;
+	if ((aLength < 1) || (aLength > 32767)) return Error::ILLEGAL_FUNCTION_CALL;
+
+	std::unique_ptr<File> f(new File());
+	f->mode = aMode;
+	f->length = aLength;
+	f->size = 0;
+	f->record = 0;
+	f->end = false;
+	f->column = 0;
+
+	// The buffer must be set before opening. Random files are read and written by blocks, through the cache only.
+	if (aMode == File::RANDOM) {
+		f->stream.rdbuf()->pubsetbuf(nullptr, 0);
+	} else {
+		f->buffer.resize(FILE_BUFFER_SIZE);
+		f->stream.rdbuf()->pubsetbuf(f->buffer.data(), f->buffer.size());
+	}
+
+	switch (aMode) {
+		case File::INPUT :
+			f->stream.open(aName, std::ios::in | std::ios::binary);
+			break;
+		case File::OUTPUT :
+			f->stream.open(aName, std::ios::out | std::ios::trunc | std::ios::binary);
+			break;
+		case File::APPEND :
+			f->stream.open(aName, std::ios::out | std::ios::app | std::ios::binary);
+			break;
+		case File::RANDOM :
+			f->stream.open(aName, std::ios::in | std::ios::out | std::ios::binary);
+			if (!f->stream.is_open()) {
+				// Created if missing.
+				f->stream.clear();
+				f->stream.open(aName, std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary);
+			}
+			break;
+	}
+	if (!f->stream.is_open()) return Error::FILE_NOT_FOUND;
+
+	if ((aMode == File::INPUT) || (aMode == File::RANDOM)) {
+		f->stream.seekg(0, std::ios::end);
+		f->size = f->stream.tellg();
+		f->stream.seekg(0);
+	}
+	channels[aChannel - 1] = std::move(f);
+	return Error::OK;
+}
+
+Error::error_t Files::close(const int aChannel)
+{
+	if ((aChannel < 1) || (aChannel > FILE_CHANNELS)) return Error::BAD_FILE_NUMBER;
+	File* f = channels[aChannel - 1].get();
+	if (!f) return Error::OK;
+
+	const auto result = (f->mode == File::RANDOM) ? cache.flush(*f) : Error::OK;
+	f->stream.close();
+	channels[aChannel - 1].reset();
+	return result;
+}
+
+Error::error_t Files::closeAll()
+{
+	Error::error_t result = Error::OK;
+	for (int i = 1; i <= FILE_CHANNELS; ++i) {
+		const auto error = close(i);
+		if (!result) result = error;
+	}
+	return result;
+}
+
+Error::error_t Files::read(File& aFile, const unsigned long aRecord, std::vector<Value>& aVariables)
+{
+	const unsigned long position = (aRecord - 1) * aFile.length;
+	aFile.record = aRecord;
+	aFile.end = position + aFile.length > aFile.size;
+
+	for (auto&& field : aFile.fields) {
+		std::string& s = aVariables[field.variable].string;
+		s.resize(field.width);
+		const auto error = cache.read(aFile, position + field.offset, &s[0], field.width);
+		if (error) return error;
+	}
+	return Error::OK;
+}
+
+Error::error_t Files::write(File& aFile, const unsigned long aRecord, const std::vector<Value>& aVariables)
+{
+	const unsigned long position = (aRecord - 1) * aFile.length;
+	aFile.record = aRecord;
+
+	// The whole record belongs to the file, fielded or not.
+	aFile.size = std::max(aFile.size, position + aFile.length);
+
+	Error::error_t error = Error::OK;
+	for (auto&& field : aFile.fields) {
+		const std::string& s = aVariables[field.variable].string;
+		const unsigned long bytes = std::min<unsigned long>(s.size(), field.width);
+		if (!error) error = cache.write(aFile, position + field.offset, s.data(), bytes);
+		if (!error && (bytes < field.width)) error = cache.fill(aFile, position + field.offset + bytes, ' ', field.width - bytes);
+	}
+	return error;
+}
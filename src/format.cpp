@@ -0,0 +1,385 @@
+/**
+ * Copyright [2024] Marc SIBERT
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include "format.h"
+#include "runtime.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+///< Most digits of a numeric field, as in GW-BASIC.
+const unsigned MAX_DIGITS = 24;
+
+/**
+ * 10^n as an integer, for n up to 19.
+ **/
+uint64_t power(const unsigned n)
+{
+	static const std::array<uint64_t, 20> table = [] {
+		std::array<uint64_t, 20> t;
+		t[0] = 1;
+		for (unsigned i = 1; i < t.size(); ++i) t[i] = t[i - 1] * 10;
+		return t;
+	}();
+	return table[n];
+}
+
+/**
+ * 10^n as a long double, exact for n up to 27.
+ **/
+long double scale(const unsigned n)
+{
+	static const std::array<long double, 28> table = [] {
+		std::array<long double, 28> t;
+		t[0] = 1;
+		for (unsigned i = 1; i < t.size(); ++i) t[i] = t[i - 1] * 10;
+		return t;
+	}();
+	return table[n];
+}
+
+/**
+ * Round a positive number to aDigits significant digits: aValue is about aMantissa * 10^(aExponent - aDigits + 1),
+ * aMantissa having exactly aDigits digits.
+ **/
+void decimal(const double aValue, const unsigned aDigits, uint64_t& aMantissa, int& aExponent)
+{
+	int e = static_cast<int>(std::floor(std::log10(aValue)));
+	// log10 may be off by one near a power of 10, as the rounding may carry to the next one.
+	for (unsigned attempt = 0; attempt < 3; ++attempt) {
+		const int k = static_cast<int>(aDigits) - 1 - e;
+		if ((k > 27) || (k < -27)) break;
+		const long double scaled = (k >= 0) ? aValue * scale(k) : aValue / scale(-k);
+		const uint64_t m = static_cast<uint64_t>(scaled + 0.5L);
+		if (m >= power(aDigits)) ++e;
+		else if (m < power(aDigits - 1)) --e;
+		else {
+			aMantissa = m;
+			aExponent = e;
+			return;
+		}
+	}
+
+	// Out of the range scaled exactly: the C library rounds, "d.ddde+XX".
+	char text[32];
+	std::snprintf(text, sizeof(text), "%.*e", aDigits - 1, aValue);
+	aMantissa = text[0] - '0';
+	for (unsigned i = 2; i < aDigits + 1; ++i) aMantissa = aMantissa * 10 + text[i] - '0';
+	aExponent = std::atoi(std::strchr(text, 'e') + 1);
+}
+
+/**
+ * Write the digits of aNumber followed by aZeros zeros, with leading zeros up to aMinimum digits.
+ * @return The count of digits written.
+ **/
+unsigned digits(uint64_t aNumber, const unsigned aZeros, const unsigned aMinimum, char* aDigits)
+{
+	char reversed[24];
+	unsigned count = 0;
+	do {
+		reversed[count++] = '0' + aNumber % 10;
+		aNumber /= 10;
+	} while (aNumber);
+
+	unsigned n = 0;
+	for (unsigned i = count + aZeros; i < aMinimum; ++i) aDigits[n++] = '0';
+	while (count) aDigits[n++] = reversed[--count];
+	std::memset(aDigits + n, '0', aZeros);
+	return n + aZeros;
+}
+
+/**
+ * The digits of a positive number rounded to aAfter decimals, with at least one digit left of the point.
+ * The SINGLE and DOUBLE numbers are rounded to their own precision first, 7 and 16 digits,
+ * so that 0.1! does not print as 0.100000001490116.
+ * @return The count of digits written in aDigits, the last aAfter ones being the decimals.
+ **/
+unsigned fixed(const Value& aValue, const double aMagnitude, const unsigned aAfter, char* aDigits)
+{
+	if ((aValue.type == Token::INTEGER) && (aAfter <= 14)) {
+		return digits(static_cast<uint64_t>(std::abs(static_cast<int32_t>(aValue.integer))) * power(aAfter), 0, aAfter + 1, aDigits);
+	}
+	if ((aMagnitude == 0) || !std::isfinite(aMagnitude)) return digits(0, 0, aAfter + 1, aDigits);
+
+	const unsigned precision = (aValue.type == Token::DOUBLE) ? 16 : 7;
+	uint64_t m;
+	int e;
+	decimal(aMagnitude, precision, m, e);
+
+	const int keep = e + 1 + static_cast<int>(aAfter);		// Digits of the rounded number.
+	uint64_t n = 0;
+	if (keep >= static_cast<int>(precision)) return digits(m, keep - precision, aAfter + 1, aDigits);
+	if (keep > 0) {
+		const unsigned drop = precision - keep;
+		n = (m + 5 * power(drop - 1)) / power(drop);
+	} else if (keep == 0) {
+		n = (m >= 5 * power(precision - 1)) ? 1 : 0;
+	}
+	return digits(n, 0, aAfter + 1, aDigits);
+}
+
+/**
+ * Write a number in a field with an exponent, the mantissa taking all the digit positions.
+ **/
+unsigned scientific(const Format::Field& aField, const Value& aValue, const double aMagnitude, const bool aNegative, char* aBuffer)
+{
+	// Without a sign in the format, the first position is kept for the one of the number.
+	const bool hasSign = aField.leadingSign || aField.trailingPlus || aField.trailingMinus;
+	unsigned integers = (hasSign || !aField.before) ? aField.before : aField.before - 1;
+	unsigned significant = integers + aField.after;
+	if (!significant) integers = significant = 1;
+
+	// The digits in a stack buffer, "d.ddde+XX".
+	char digits[64];
+	const unsigned precision = std::min(significant, (aValue.type == Token::DOUBLE) ? 16u : 7u);
+	std::snprintf(digits, sizeof(digits), "%.*e", precision - 1, aMagnitude);
+	const char* const pE = std::strchr(digits, 'e');
+	int exponent = std::atoi(pE + 1);
+	if (aMagnitude != 0) exponent -= static_cast<int>(integers) - 1;
+
+	unsigned n = 0;
+	if (aField.leadingSign) aBuffer[n++] = aNegative ? '-' : '+';
+	else if (!hasSign && aField.before) aBuffer[n++] = aNegative ? '-' : ' ';
+
+	// The mantissa, padded with zeros past the precision of the number.
+	unsigned written = 0;
+	auto digit = [&]() {
+		const unsigned i = written ? written + 1 : 0;
+		++written;
+		return (written <= precision) ? digits[i] : '0';
+	};
+	for (unsigned i = 0; i < integers; ++i) aBuffer[n++] = digit();
+	if (aField.point) {
+		aBuffer[n++] = '.';
+		for (unsigned i = 0; i < aField.after; ++i) aBuffer[n++] = digit();
+	}
+
+	aBuffer[n++] = 'E';
+	aBuffer[n++] = (exponent < 0) ? '-' : '+';
+	unsigned e = std::abs(exponent);
+	char reversed[8];
+	unsigned count = 0;
+	do {
+		reversed[count++] = '0' + e % 10;
+		e /= 10;
+	} while (e);
+	while (count < aField.exponent - 2) reversed[count++] = '0';
+	while (count) aBuffer[n++] = reversed[--count];
+
+	if (aField.trailingPlus) aBuffer[n++] = aNegative ? '-' : '+';
+	else if (aField.trailingMinus) aBuffer[n++] = aNegative ? '-' : ' ';
+	return n;
+}
+
+/**
+ * Write spaces, without building a string.
+ **/
+void pad(Runtime& aRuntime, std::size_t aCount)
+{
+	static const char spaces[] = "                                ";
+	while (aCount) {
+		const std::size_t n = std::min(aCount, sizeof(spaces) - 1);
+		aRuntime.print(spaces, n);
+		aCount -= n;
+	}
+}
+
+}
+
+Error::error_t Format::compile(const std::string& aFormat)
+{
+	text.clear();
+	fields.clear();
+	values = 0;
+
+	const std::size_t size = aFormat.size();
+	auto at = [&](const std::size_t i) {
+		return (i < size) ? aFormat[i] : '\0';
+	};
+
+	for (std::size_t i = 0; i < size; ) {
+		Field field = Field();
+		const char c = at(i), d = at(i + 1), e = at(i + 2);
+		std::size_t end;
+
+		if (c == '!') {
+			field.kind = Field::FIRST;
+			++i;
+		} else if (c == '&') {
+			field.kind = Field::WHOLE;
+			++i;
+		} else if ((c == '\\') && ((end = aFormat.find_first_not_of(' ', i + 1)) != std::string::npos) && (aFormat[end] == '\\')) {
+			field.kind = Field::FIXED;
+			field.length = end - i + 1;
+			i = end + 1;
+		} else if ((c == '#') || ((c == '.') && (d == '#')) || ((c == '*') && (d == '*')) || ((c == '$') && (d == '$')) ||
+				((c == '+') && ((d == '#') || ((d == '.') && (e == '#')) || ((d == '*') && (e == '*')) || ((d == '$') && (e == '$'))))) {
+			field.kind = Field::NUMBER;
+			if (at(i) == '+') {
+				field.leadingSign = true;
+				++i;
+			}
+			if ((at(i) == '*') && (at(i + 1) == '*')) {
+				field.asterisk = true;
+				field.before += 2;
+				i += 2;
+				if (at(i) == '$') {
+					field.dollar = true;
+					++field.before;
+					++i;
+				}
+			} else if ((at(i) == '$') && (at(i + 1) == '$')) {
+				field.dollar = true;
+				field.before += 2;
+				i += 2;
+			}
+			for (;; ++i) {
+				if (at(i) == '#') ++field.before;
+				else if ((at(i) == ',') && !field.point && ((at(i + 1) == '#') || (at(i + 1) == ',') || (at(i + 1) == '.'))) {
+					field.comma = true;
+					++field.before;
+				} else if ((at(i) == '.') && !field.point) field.point = true;
+				else break;
+				if (field.point && (at(i) == '#')) {
+					--field.before;
+					++field.after;
+				}
+			}
+			if (aFormat.compare(i, 4, "^^^^") == 0) {
+				field.exponent = (aFormat.compare(i, 5, "^^^^^") == 0) ? 5 : 4;
+				i += field.exponent;
+			}
+			if (!field.leadingSign && (at(i) == '+')) {
+				field.trailingPlus = true;
+				++i;
+			} else if (!field.leadingSign && (at(i) == '-')) {
+				field.trailingMinus = true;
+				++i;
+			}
+			if (field.before + field.after > MAX_DIGITS) return Error::ILLEGAL_FUNCTION_CALL;
+		} else {
+			// Literal text, '_' quoting the character following it.
+			if ((c == '_') && (i + 1 < size)) ++i;
+			if (fields.empty() || (fields.back().kind != Field::LITERAL)) {
+				field.kind = Field::LITERAL;
+				field.offset = text.size();
+				fields.push_back(field);
+			}
+			text += aFormat[i++];
+			++fields.back().length;
+			continue;
+		}
+		fields.push_back(field);
+		++values;
+	}
+	return values ? Error::OK : Error::ILLEGAL_FUNCTION_CALL;
+}
+
+Error::error_t Format::print(Runtime& aRuntime, const Value& aValue, unsigned& aNext) const
+{
+	literals(aRuntime, aNext);
+	if (aNext == fields.size()) {
+		aNext = 0;
+		literals(aRuntime, aNext);
+	}
+
+	const Field& field = fields[aNext++];
+	if ((field.kind == Field::NUMBER) == aValue.isString()) return Error::TYPE_MISMATCH;
+
+	switch (field.kind) {
+		case Field::FIRST :
+			if (aValue.string.empty()) pad(aRuntime, 1);
+			else aRuntime.print(aValue.string.data(), 1);
+			break;
+		case Field::FIXED :
+			aRuntime.print(aValue.string.data(), std::min<std::size_t>(aValue.string.size(), field.length));
+			if (aValue.string.size() < field.length) pad(aRuntime, field.length - aValue.string.size());
+			break;
+		case Field::WHOLE :
+			aRuntime.print(aValue.string.data(), aValue.string.size());
+			break;
+		default : {
+			char buffer[BUFFER_SIZE];
+			aRuntime.print(buffer, number(field, aValue, buffer));
+		}
+	}
+	return Error::OK;
+}
+
+void Format::finish(Runtime& aRuntime, unsigned aNext) const
+{
+	literals(aRuntime, aNext);
+}
+
+void Format::literals(Runtime& aRuntime, unsigned& aNext) const
+{
+	while ((aNext < fields.size()) && (fields[aNext].kind == Field::LITERAL)) {
+		aRuntime.print(text.data() + fields[aNext].offset, fields[aNext].length);
+		++aNext;
+	}
+}
+
+unsigned Format::number(const Field& aField, const Value& aValue, char* aBuffer)
+{
+	const double value = aValue.toDouble();
+	const double magnitude = std::fabs(value);
+	if (aField.exponent) return scientific(aField, aValue, magnitude, value < 0, aBuffer);
+
+	char digits[BUFFER_SIZE];
+	const unsigned count = fixed(aValue, magnitude, aField.after, digits);
+	const unsigned integers = count - aField.after;
+	// A number rounded to zero prints without its sign.
+	const bool negative = (value < 0) && (std::count(digits, digits + count, '0') != static_cast<std::ptrdiff_t>(count));
+
+	char sign = 0;
+	if (aField.leadingSign) sign = negative ? '-' : '+';
+	else if (negative && !aField.trailingPlus && !aField.trailingMinus) sign = '-';
+
+	// The 0 left of the point gives way to the sign when the field is too narrow for both.
+	const unsigned commas = aField.comma ? (integers - 1) / 3 : 0;
+	unsigned width = (sign ? 1 : 0) + (aField.dollar ? 1 : 0) + integers + commas;
+	const unsigned room = aField.before + (aField.leadingSign ? 1 : 0);
+	unsigned first = 0;
+	if ((integers == 1) && (digits[0] == '0') && aField.point && (width > room)) {
+		first = 1;
+		--width;
+	}
+
+	unsigned n = 0;
+	if (width > room) aBuffer[n++] = '%';
+	else for (unsigned i = width; i < room; ++i) aBuffer[n++] = aField.asterisk ? '*' : ' ';
+	if (sign) aBuffer[n++] = sign;
+	if (aField.dollar) aBuffer[n++] = '$';
+	for (unsigned i = first; i < integers; ++i) {
+		aBuffer[n++] = digits[i];
+		if (aField.comma && (i + 1 < integers) && ((integers - 1 - i) % 3 == 0)) aBuffer[n++] = ',';
+	}
+	if (aField.point) {
+		aBuffer[n++] = '.';
+		std::memcpy(aBuffer + n, digits + integers, aField.after);
+		n += aField.after;
+	}
+
+	if (aField.trailingPlus) aBuffer[n++] = negative ? '-' : '+';
+	else if (aField.trailingMinus) aBuffer[n++] = negative ? '-' : ' ';
+	return n;
+}
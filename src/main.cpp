@@ -18,33 +18,510 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <cstdio>
+#include <cctype>
+#ifndef _WIN32
+#include <csignal>
+#include <pthread.h>
+#endif
 
 #include "interpreter.h"
+#include "memstat.h"
 
-int main()
+/**
+ * One program of a batch and, once run, what was measured.
+ **/
+struct Job {
+	std::string file;			///< BASIC program to load, or snapshot (.snap) to restore.
+	std::string script;			///< File read as stdin by INPUT, or empty for none.
+	std::vector<std::string> edits;	///< RENUM, DELETE and MERGE commands applied to the program once loaded.
+
+	Error::error_t status;		///< Exit status of the load, then of the run.
+	std::string message;		///< Everything the interpreter wrote on its error stream.
+	double loadTime;			///< Milliseconds spent in Interpreter::load, or Interpreter::restore.
+	double runTime;				///< Milliseconds spent in Interpreter::run, or Interpreter::cont.
+	unsigned long long statements;
+	unsigned long long allocations;	///< Calls to operator new during Interpreter::run.
+	long long peakMemory;		///< Bytes, for this program only.
+
+	/**
+	 * Speed of the run, or 0 if nothing was run.
+	 **/
+	double statementsPerSecond() const {
+		return runTime > 0 ? statements * 1000.0 / runTime : 0;
+	}
+};
+
+/**
+ * Reference measures of a program, as stored in a baseline file.
+ **/
+struct Reference {
+	unsigned long long statements;
+	unsigned long long allocations;
+	double statementsPerSecond;		///< Of the machine the baseline was written on, for information only.
+};
+
+/**
+ * File name of a program without its directory, naming its output and its snapshot.
+ **/
+static std::string baseName(const std::string& aFile)
+{
+	const auto slash = aFile.find_last_of("/\\");
+	return aFile.substr(slash == std::string::npos ? 0 : slash + 1);
+}
+
+/**
+ * Line numbers of the arguments of an edit command, split on aSeparator, 0 for the ones left out.
+ * @return false if one is not a line number.
+ **/
+static bool editArguments(const std::string& aArguments, const char aSeparator, std::vector<unsigned>& aNumbers)
+{
+	std::string argument;
+	std::istringstream in(aArguments);
+	while (std::getline(in, argument, aSeparator)) {
+		unsigned number = 0;
+		if (!argument.empty() && !lineNumber(argument, number)) return false;
+		aNumbers.push_back(number);
+	}
+	if (!aArguments.empty() && (aArguments.back() == aSeparator)) aNumbers.push_back(0);
+	return true;
+}
+
+/**
+ * Edit the program loaded with a command in direct mode: RENUM [new][,[old][,increment]], DELETE [first][-[last]],
+ * or MERGE file.
+ * @return SYNTAX_ERROR if the command is not one of them, else the error of the edit.
+ **/
+static Error::error_t edit(Interpreter& aInterpreter, const std::string& aCommand)
+{
+	std::istringstream in(aCommand);
+	std::string keyword, arguments;
+	in >> keyword >> std::ws;
+	std::getline(in, arguments);
+	for (auto& c : keyword) c = std::toupper(c);
+
+	if (keyword == "MERGE") {
+		std::ifstream file(arguments);
+		return file ? aInterpreter.merge(file) : Error::FILE_NOT_FOUND;
+	}
+
+	std::string compact;
+	for (auto c : arguments) if (c != ' ') compact += c;
+	std::vector<unsigned> numbers;
+	if (keyword == "RENUM") {
+		if (!editArguments(compact, ',', numbers) || (numbers.size() > 3)) return Error::SYNTAX_ERROR;
+		const unsigned increment = numbers.size() > 2 ? numbers[2] : 10;
+		numbers.resize(2);
+		return aInterpreter.renumber(numbers[0] ? numbers[0] : 10, numbers[1], increment);
+	}
+	if (keyword == "DELETE") {
+		if (compact.empty()) return Error::ILLEGAL_FUNCTION_CALL;
+		if (!editArguments(compact, '-', numbers) || (numbers.size() > 2)) return Error::SYNTAX_ERROR;
+		if (numbers.size() == 1) return aInterpreter.erase(numbers[0]);
+		// Only the form -last starts from the first line, a first line written, 0 included, must exist.
+		if (compact[0] == '-') return aInterpreter.eraseUpTo(numbers[1]);
+		return aInterpreter.erase(numbers[0], numbers[1] ? numbers[1] : MAX_LINE_NUMBER);
+	}
+	return Error::SYNTAX_ERROR;
+}
+
+/**
+ * Counters of the programs of the batch, for -m.
+ **/
+static struct {
+	std::mutex mutex;									///< Of running and finished, not of the counters.
+	std::map<const Metrics*, std::string> running;		///< File of each program running.
+	std::map<std::string, Metrics::Counters> finished;	///< Last run of each file.
+} programs;
+
+/**
+ * Record a program as running while it exists, then keep its last counters.
+ **/
+class Running {
+	public:
+		Running(const Metrics& aMetrics, const std::string& aFile) : metrics(aMetrics) {
+			std::lock_guard<std::mutex> lock(programs.mutex);
+			programs.running[&metrics] = aFile;
+		}
+
+		~Running() {
+			std::lock_guard<std::mutex> lock(programs.mutex);
+			const auto it = programs.running.find(&metrics);
+			programs.finished[it->second] = metrics.snapshot();
+			programs.running.erase(it);
+		}
+
+	private:
+		const Metrics& metrics;
+};
+
+/**
+ * Write the counters of the programs, running or finished, in the Prometheus text format.
+ * The file is written aside then renamed, so that a reader never sees half of it.
+ **/
+static void dumpMetrics(const std::string& aFile)
+{
+	std::map<std::string, Metrics::Counters> all;
+	{
+		std::lock_guard<std::mutex> lock(programs.mutex);
+		all = programs.finished;
+		for (auto&& program : programs.running) all[program.second] = program.first->snapshot();
+	}
+
+	const std::string temporary = aFile + ".tmp";
+	{
+		std::ofstream out(temporary);
+		Metrics::write(out, std::vector<std::pair<std::string, Metrics::Counters>>(all.cbegin(), all.cend()));
+	}
+	std::rename(temporary.c_str(), aFile.c_str());
+}
+
+/**
+ * Load and run one job, non-interactively, in the calling thread.
+ * @param aJob The job to run, updated with its measures.
+ * @param aOutput Directory receiving the program output (as <file>.out), or empty to discard it.
+ * @param aSnapshots Directory receiving a snapshot of the program (as <file>.snap) when it STOPs, or empty for none.
+ * @param aMode How the program is loaded.
+ * @param aList List the program on its output instead of running it.
+ **/
+static void runJob(Job& aJob, const std::string& aOutput, const std::string& aSnapshots, const Interpreter::mode_t aMode, const bool aList)
+{
+	typedef std::chrono::steady_clock clock;
+
+	MemStat::reset();
+	aJob.status = Error::OK;
+	aJob.loadTime = aJob.runTime = 0;
+	aJob.statements = aJob.allocations = 0;
+
+	std::ostringstream err;
+	{
+		const bool snapshot = (aJob.file.size() > 5) && !aJob.file.compare(aJob.file.size() - 5, 5, ".snap");
+		std::ifstream file(aJob.file, snapshot ? std::ios::binary : std::ios::in);
+		std::ifstream script;
+		std::istringstream none;
+		std::ofstream output;
+		std::ostream discard(nullptr);
+
+		if (!aJob.script.empty()) script.open(aJob.script);
+		const std::string name = baseName(aJob.file);
+		if (!aOutput.empty()) output.open(aOutput + '/' + name + ".out");
+
+		if (!file) {
+			err << "Error opening file!" << std::endl;
+			aJob.status = Error::FILE_NOT_FOUND;
+		} else if (!aJob.script.empty() && !script) {
+			err << "Error opening script!" << std::endl;
+			aJob.status = Error::FILE_NOT_FOUND;
+		} else {
+			Interpreter interpreter(aJob.script.empty() ? static_cast<std::istream&>(none) : script,
+			                        output.is_open() ? static_cast<std::ostream&>(output) : discard,
+			                        err, CONTROL_STACK_DEPTH, aMode);
+			const Running running(interpreter.getMetrics(), aJob.file);
+
+			const auto t0 = clock::now();
+			aJob.status = snapshot ? interpreter.restore(file) : interpreter.load(file, aJob.file);
+			for (auto itEdit = aJob.edits.cbegin(); !snapshot && (aJob.status == Error::OK) && (itEdit != aJob.edits.cend()); ++itEdit) {
+				aJob.status = edit(interpreter, *itEdit);
+				if (aJob.status != Error::OK) err << Error::message(aJob.status) << " in " << *itEdit << std::endl;
+			}
+			const auto t1 = clock::now();
+			const auto allocations = MemStat::allocations();
+			if (aJob.status == Error::OK) aJob.status = aList ? interpreter.list() : (snapshot ? interpreter.cont() : interpreter.run());
+			const auto t2 = clock::now();
+			aJob.allocations = MemStat::allocations() - allocations;
+
+			aJob.loadTime = std::chrono::duration<double, std::milli>(t1 - t0).count();
+			aJob.runTime = std::chrono::duration<double, std::milli>(t2 - t1).count();
+			aJob.statements = interpreter.getStatements();
+
+			if ((aJob.status == Error::OK) && !aSnapshots.empty() && interpreter.isStopped()) {
+				std::ofstream snap(aSnapshots + '/' + (snapshot ? name.substr(0, name.size() - 5) : name) + ".snap", std::ios::binary);
+				aJob.status = interpreter.snapshot(snap);
+			}
+		}
+	}
+	aJob.peakMemory = MemStat::peak();
+	aJob.message = err.str();
+}
+
+/**
+ * Write a string as a JSON literal.
+ **/
+static void jsonString(std::ostream& out, const std::string& aString)
 {
-	Interpreter interpreter;
-	std::cout << interpreter;
+	out << '"';
+	for (auto c : aString) {
+		switch (c) {
+			case '"' : out << "\\\""; break;
+			case '\\' : out << "\\\\"; break;
+			case '\n' : out << "\\n"; break;
+			case '\r' : out << "\\r"; break;
+			case '\t' : out << "\\t"; break;
+			default :
+				if (static_cast<unsigned char>(c) < 0x20) {
+					const char hex[] = "0123456789abcdef";
+					out << "\\u00" << hex[(c >> 4) & 0xF] << hex[c & 0xF];
+				} else out << c;
+		}
+	}
+	out << '"';
+}
 
-	/*
-	    while (std::cin) std::cin >> interpreter;
-	*/
+/**
+ * Write the report of all jobs as a JSON array, one object per program.
+ **/
+static void report(std::ostream& out, const std::vector<Job>& aJobs)
+{
+	out << '[' << std::endl;
+	for (auto&& job : aJobs) {
+		out << "  {\"file\": ";
+		jsonString(out, job.file);
+		out << ", \"script\": ";
+		jsonString(out, job.script);
+		out << ", \"load_ms\": " << job.loadTime
+		    << ", \"run_ms\": " << job.runTime
+		    << ", \"statements\": " << job.statements
+		    << ", \"statements_per_sec\": " << job.statementsPerSecond()
+		    << ", \"allocations\": " << job.allocations
+		    << ", \"peak_bytes\": " << job.peakMemory
+		    << ", \"status\": " << job.status
+		    << ", \"error\": ";
+		jsonString(out, job.status == Error::OK ? "" : Error::message(job.status));
+		out << ", \"message\": ";
+		jsonString(out, job.message);
+		out << '}' << (&job == &aJobs.back() ? "" : ",") << std::endl;
+	}
+	out << ']' << std::endl;
+}
 
-	Tokenizer tokenizer;
+/**
+ * Read a baseline file: one "file statements allocations statements_per_sec" line per program, '#' starts a comment.
+ * @return false if the file cannot be read.
+ **/
+static bool readBaseline(const std::string& aFile, std::map<std::string, Reference>& aBaseline)
+{
+	std::ifstream in(aFile);
+	if (!in) return false;
 
-	std::ifstream file;
-	file.open("C:\\Users\\marc\\Documents\\GitHub\\MS-Basic\\eliza.bas", std::ios::in);
+	std::string line;
+	while (std::getline(in, line)) {
+		std::istringstream s(line.substr(0, line.find('#')));
+		std::string file;
+		Reference reference;
+		if (s >> file >> reference.statements >> reference.allocations >> reference.statementsPerSecond) aBaseline[file] = reference;
+	}
+	return true;
+}
 
-	if (!file) {
-		std::cerr << "Error opening file!" << std::endl;
-		exit(-1);
+/**
+ * Write the measures of the jobs as a new baseline file.
+ **/
+static void writeBaseline(std::ostream& out, const std::vector<Job>& aJobs)
+{
+	out << "# file statements allocations statements_per_sec" << std::endl;
+	for (auto&& job : aJobs) {
+		out << job.file << ' ' << job.statements << ' ' << job.allocations << ' ' << static_cast<unsigned long long>(job.statementsPerSecond()) << std::endl;
+	}
+}
+
+/**
+ * Compare the jobs with their baseline, writing one line per program.
+ * A program regresses when it executes more statements, or allocates more, than its reference by more than
+ * aThreshold percent: these counters do not depend on the machine nor on its load, unlike the speed which
+ * is only reported.
+ * @return the number of regressions.
+ **/
+static unsigned compare(std::ostream& out, const std::vector<Job>& aJobs, const std::map<std::string, Reference>& aBaseline, const double aThreshold)
+{
+	unsigned regressions = 0;
+	for (auto&& job : aJobs) {
+		const auto it = aBaseline.find(job.file);
+		if (it == aBaseline.cend()) {
+			out << job.file << ": no baseline" << std::endl;
+			continue;
+		}
+		const double speed = it->second.statementsPerSecond > 0 ? 100.0 * job.statementsPerSecond() / it->second.statementsPerSecond - 100 : 0;
+		const bool longer = job.statements > it->second.statements * (1 + aThreshold / 100);
+		const bool fatter = job.allocations > it->second.allocations * (1 + aThreshold / 100);
+		out << job.file << ": " << job.statements << " statements (baseline " << it->second.statements << "), "
+		    << job.allocations << " allocations (baseline " << it->second.allocations << "), "
+		    << static_cast<unsigned long long>(job.statementsPerSecond()) << " statements/s ("
+		    << std::showpos << std::fixed << std::setprecision(1) << speed << std::noshowpos << "%)"
+		    << (longer || fatter ? " REGRESSION" : "") << std::endl;
+		out.unsetf(std::ios::fixed);
+		if (longer || fatter) ++regressions;
+	}
+	return regressions;
+}
+
+static void usage(std::ostream& out)
+{
+	out << "Usage: ms-basic [-j jobs] [-n runs] [-O|-L] [-l] [-e command] [-o dir] [-s dir] [-r report] [-b baseline [-t percent]] [-w baseline] [-m metrics] [[-i script] file.bas|file.snap]..." << std::endl
+	    << "  -j jobs    run up to <jobs> programs in parallel (default 1)" << std::endl
+	    << "  -n runs    run each program <runs> times and keep the fastest run (default 1)" << std::endl
+	    << "  -O         optimized load: drop REM and fuse the lines never jumped to" << std::endl
+	    << "  -L         lazy load: compile each line when first run" << std::endl
+	    << "  -l         list the programs on their output instead of running them" << std::endl
+	    << "  -e command edit the following programs once loaded with RENUM, DELETE or MERGE <command>," << std::endl
+	    << "             after the ones of the previous -e (- for none)" << std::endl
+	    << "  -i script  feed <script> to INPUT for the following programs (- for none)" << std::endl
+	    << "  -o dir     write each program output to <dir>/<file>.out (default discarded)" << std::endl
+	    << "  -s dir     write a snapshot of each program STOPped to <dir>/<file>.snap, to go on with later" << std::endl
+	    << "  -r report  write the JSON report to <report> (default stdout)" << std::endl
+	    << "  -b file    compare statements and allocations with the baseline <file>, fail on regression" << std::endl
+	    << "  -t percent regression threshold for -b (default 0)" << std::endl
+	    << "  -w file    write the measures as a new baseline <file>" << std::endl
+	    << "  -m file    write the counters of the programs to <file> in the Prometheus text format," << std::endl
+	    << "             on SIGUSR1 while they run and once they are all done" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+	std::vector<Job> jobs;
+	unsigned parallel = 1, runs = 1;
+	Interpreter::mode_t mode = Interpreter::EAGER;
+	bool list = false;
+	std::vector<std::string> edits;
+	std::string script, output, snapshots, reportFile, baselineFile, newBaselineFile, metricsFile;
+	double threshold = 0;
+
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg(argv[i]);
+		if ((arg == "-j" || arg == "-n" || arg == "-i" || arg == "-e" || arg == "-o" || arg == "-s" || arg == "-r" || arg == "-b" || arg == "-t" || arg == "-w" || arg == "-m") && i + 1 >= argc) {
+			usage(std::cerr);
+			return EXIT_FAILURE;
+		}
+		if (arg == "-j") {
+			parallel = std::max(1, std::atoi(argv[++i]));
+		} else if (arg == "-n") {
+			runs = std::max(1, std::atoi(argv[++i]));
+		} else if (arg == "-O") {
+			mode = Interpreter::OPTIMIZED;
+		} else if (arg == "-L") {
+			mode = Interpreter::LAZY;
+		} else if (arg == "-l") {
+			list = true;
+		} else if (arg == "-i") {
+			script = argv[++i];
+			if (script == "-") script.clear();
+		} else if (arg == "-e") {
+			if (std::string(argv[++i]) == "-") edits.clear();
+			else edits.push_back(argv[i]);
+		} else if (arg == "-o") {
+			output = argv[++i];
+		} else if (arg == "-s") {
+			snapshots = argv[++i];
+		} else if (arg == "-r") {
+			reportFile = argv[++i];
+		} else if (arg == "-b") {
+			baselineFile = argv[++i];
+		} else if (arg == "-t") {
+			threshold = std::atof(argv[++i]);
+		} else if (arg == "-w") {
+			newBaselineFile = argv[++i];
+		} else if (arg == "-m") {
+			metricsFile = argv[++i];
+		} else if (arg == "-h" || arg == "--help") {
+			usage(std::cout);
+			return EXIT_SUCCESS;
+		} else {
+			Job job;
+			job.file = arg;
+			job.script = script;
+			job.edits = edits;
+			jobs.push_back(job);
+		}
+	}
+
+	// The outputs and snapshots are named after the programs: two programs of the same name would overwrite each other's.
+	if (!output.empty() || !snapshots.empty()) {
+		std::map<std::string, std::string> names;
+		for (auto&& job : jobs) {
+			const auto it = names.insert(std::make_pair(baseName(job.file), job.file));
+			if (!it.second) {
+				std::cerr << "Programs " << it.first->second << " and " << job.file << " would write the same output, run them apart" << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	std::map<std::string, Reference> baseline;
+	if (!baselineFile.empty() && !readBaseline(baselineFile, baseline)) {
+		std::cerr << "Error opening baseline " << baselineFile << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	if (jobs.empty()) {
+		Interpreter interpreter;
+		std::cout << interpreter;
+		usage(std::cerr);
+		return EXIT_SUCCESS;
+	}
+
+#ifndef _WIN32
+	// SIGUSR1 is blocked in all the threads but waited for by the one writing the counters.
+	std::atomic<bool> done(false);
+	std::thread watcher;
+	sigset_t signals;
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGUSR1);
+	if (!metricsFile.empty()) {
+		pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+		watcher = std::thread([&]() {
+			int signal;
+			while (!sigwait(&signals, &signal) && !done) dumpMetrics(metricsFile);
+		});
+	}
+#endif
+
+	std::atomic<unsigned> next(0);
+	auto worker = [&]() {
+		for (unsigned i = next++; i < jobs.size(); i = next++) {
+			runJob(jobs[i], output, snapshots, mode, list);
+			for (unsigned r = 1; (r < runs) && (jobs[i].status == Error::OK); ++r) {
+				Job job = jobs[i];
+				runJob(job, output, snapshots, mode, list);
+				if (job.runTime < jobs[i].runTime) jobs[i] = job;
+			}
+		}
+	};
+	std::vector<std::thread> threads;
+	for (unsigned i = 1; i < std::min<std::size_t>(parallel, jobs.size()); ++i) threads.push_back(std::thread(worker));
+	worker();
+	for (auto&& thread : threads) thread.join();
+
+	if (!metricsFile.empty()) {
+#ifndef _WIN32
+		done = true;
+		pthread_kill(watcher.native_handle(), SIGUSR1);
+		watcher.join();
+#endif
+		dumpMetrics(metricsFile);
+	}
+
+	if (reportFile.empty()) {
+		report(std::cout, jobs);
 	} else {
-		interpreter.load(file);
-		file.close();
+		std::ofstream file(reportFile);
+		report(file, jobs);
 	}
-	
-	interpreter.run();
-	
-	return 0;
+
+	if (!newBaselineFile.empty()) {
+		std::ofstream file(newBaselineFile);
+		writeBaseline(file, jobs);
+	}
+
+	for (auto&& job : jobs) if (job.status != Error::OK) return EXIT_FAILURE;
+	if (!baselineFile.empty() && compare(std::cerr, jobs, baseline, threshold)) return EXIT_FAILURE;
+	return EXIT_SUCCESS;
 }
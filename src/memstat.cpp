@@ -0,0 +1,118 @@
+/**
+ * Copyright [2024] Marc SIBERT
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include "memstat.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+///< Room kept in front of each block to remember its size (keeps the max alignment).
+const std::size_t header = sizeof(std::max_align_t);
+
+struct Counters {
+	long long current;
+	long long peak;
+	unsigned long long allocations;
+};
+
+thread_local Counters counters = { 0, 0, 0 };
+
+void* allocate(const std::size_t aSize)
+{
+	void* const p = std::malloc(aSize + header);
+	if (!p) return nullptr;
+	*static_cast<std::size_t*>(p) = aSize;
+	++counters.allocations;
+	counters.current += aSize;
+	if (counters.current > counters.peak) counters.peak = counters.current;
+	return static_cast<char*>(p) + header;
+}
+
+void release(void* const aPtr)
+{
+	if (!aPtr) return;
+	void* const p = static_cast<char*>(aPtr) - header;
+	counters.current -= *static_cast<std::size_t*>(p);
+	std::free(p);
+}
+
+}
+
+void MemStat::reset()
+{
+	counters.current = 0;
+	counters.peak = 0;
+	counters.allocations = 0;
+}
+
+long long MemStat::current()
+{
+	return counters.current;
+}
+
+long long MemStat::peak()
+{
+	return counters.peak;
+}
+
+unsigned long long MemStat::allocations()
+{
+	return counters.allocations;
+}
+
+void* operator new(std::size_t aSize)
+{
+	void* const p = allocate(aSize);
+	if (!p) throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](std::size_t aSize)
+{
+	return operator new(aSize);
+}
+
+void* operator new(std::size_t aSize, const std::nothrow_t&) noexcept
+{
+	return allocate(aSize);
+}
+
+void* operator new[](std::size_t aSize, const std::nothrow_t&) noexcept
+{
+	return allocate(aSize);
+}
+
+void operator delete(void* aPtr) noexcept
+{
+	release(aPtr);
+}
+
+void operator delete[](void* aPtr) noexcept
+{
+	release(aPtr);
+}
+
+void operator delete(void* aPtr, const std::nothrow_t&) noexcept
+{
+	release(aPtr);
+}
+
+void operator delete[](void* aPtr, const std::nothrow_t&) noexcept
+{
+	release(aPtr);
+}
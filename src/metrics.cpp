@@ -0,0 +1,121 @@
+/**
+ * Copyright [2024] Marc SIBERT
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include "metrics.h"
+
+#include <cstring>
+
+namespace {
+
+///< Label of each opcode, in the order of Expression::opcode_t.
+const char* const opcodes[] = {
+	"push_constant", "push_string_constant", "push_variable", "push_string_variable", "push_element", "call",
+	"integer_to_single", "integer_to_double", "single_to_integer",
+	"single_to_double", "double_to_integer", "double_to_single",
+	"negate_integer", "negate_single", "negate_double", "not",
+	"add_integer", "add_single", "add_double", "concat",
+	"subtract_integer", "subtract_single", "subtract_double",
+	"multiply_integer", "multiply_single", "multiply_double",
+	"divide_single", "divide_double",
+	"power_single", "power_double",
+	"integer_divide", "modulo", "and", "or", "xor", "eqv", "imp",
+	"compare_integer", "compare_single", "compare_double", "compare_string"
+};
+
+static_assert(sizeof(opcodes) / sizeof(opcodes[0]) == Metrics::OPCODES, "a label for each opcode");
+
+/**
+ * Write the label of a file, quoted and escaped as Prometheus expects.
+ **/
+void label(std::ostream& aOut, const std::string& aFile)
+{
+	aOut << "{file=\"";
+	for (auto c : aFile) {
+		if (c == '\n') aOut << "\\n";
+		else {
+			if ((c == '"') || (c == '\\')) aOut << '\\';
+			aOut << c;
+		}
+	}
+	aOut << '"';
+}
+
+/**
+ * Write a metric holding a single value per program.
+ **/
+void family(std::ostream& aOut, const std::vector<std::pair<std::string, Metrics::Counters>>& aPrograms,
+		const char* aName, const char* aType, const char* aHelp, uint64_t Metrics::Counters::* aCounter)
+{
+	aOut << "# HELP " << aName << ' ' << aHelp << '\n'
+	     << "# TYPE " << aName << ' ' << aType << '\n';
+	for (auto&& program : aPrograms) {
+		aOut << aName;
+		label(aOut, program.first);
+		aOut << "} " << program.second.*aCounter << '\n';
+	}
+}
+
+}
+
+void Metrics::publish(const Counters& aCounters)
+{
+	uint64_t values[WORDS];
+	std::memcpy(values, &aCounters, sizeof(values));
+
+	// Seqlock: the sequence is odd while the words change.
+	const unsigned s = sequence.load(std::memory_order_relaxed);
+	sequence.store(s + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	for (unsigned i = 0; i < WORDS; ++i) words[i].store(values[i], std::memory_order_relaxed);
+	sequence.store(s + 2, std::memory_order_release);
+}
+
+Metrics::Counters Metrics::snapshot() const
+{
+	uint64_t values[WORDS];
+	unsigned before, after;
+	do {
+		before = sequence.load(std::memory_order_acquire);
+		for (unsigned i = 0; i < WORDS; ++i) values[i] = words[i].load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		after = sequence.load(std::memory_order_relaxed);
+	} while ((before & 1) || (before != after));
+
+	Counters counters;
+	std::memcpy(&counters, values, sizeof(values));
+	return counters;
+}
+
+void Metrics::write(std::ostream& aOut, const std::vector<std::pair<std::string, Counters>>& aPrograms)
+{
+	family(aOut, aPrograms, "msbasic_statements_total", "counter", "Statements executed.", &Counters::statements);
+#if METRICS
+	aOut << "# HELP msbasic_operations_total Expression operations executed, by opcode.\n"
+	     << "# TYPE msbasic_operations_total counter\n";
+	for (auto&& program : aPrograms) {
+		for (unsigned i = 0; i < OPCODES; ++i) {
+			if (!program.second.operations[i]) continue;
+			aOut << "msbasic_operations_total";
+			label(aOut, program.first);
+			aOut << ",opcode=\"" << opcodes[i] << "\"} " << program.second.operations[i] << '\n';
+		}
+	}
+	family(aOut, aPrograms, "msbasic_control_stack_peak", "gauge", "Most GOSUB, FOR and WHILE frames at a time.", &Counters::controlStackPeak);
+#endif
+	family(aOut, aPrograms, "msbasic_allocations_total", "counter", "Calls to operator new.", &Counters::allocations);
+	family(aOut, aPrograms, "msbasic_heap_bytes", "gauge", "Heap bytes in use.", &Counters::heapBytes);
+	family(aOut, aPrograms, "msbasic_heap_peak_bytes", "gauge", "Most heap bytes in use at a time.", &Counters::heapPeak);
+}
@@ -0,0 +1,415 @@
+/**
+ * Copyright [2024] Marc SIBERT
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include "parser.h"
+#include "runtime.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+Parser::Parser(const iterator& aStart, const iterator& aStop, Runtime& aRuntime) :
+	pos(aStart),
+	stop(aStop),
+	runtime(aRuntime),
+	error(Error::SYNTAX_ERROR)
+{
+}
+
+bool Parser::atEnd() const
+{
+	return done() || isInstruction("ELSE");
+}
+
+bool Parser::isInstruction(const char* aName) const
+{
+	if (done()) return false;
+	const auto pTI = dynamic_cast<const TokenInstruction*>(*pos);
+	return pTI && (pTI->getString() == aName);
+}
+
+bool Parser::isOperator(const char* aName) const
+{
+	if (done()) return false;
+	const auto pTO = dynamic_cast<const TokenOperator*>(*pos);
+	return pTO && (pTO->getId() == aName);
+}
+
+bool Parser::isSeparator(const char* aName) const
+{
+	if (done()) return false;
+	const auto pTS = dynamic_cast<const TokenSeparator*>(*pos);
+	return pTS && (pTS->getId() == aName);
+}
+
+bool Parser::acceptInstruction(const char* aName)
+{
+	if (!isInstruction(aName)) return false;
+	next();
+	return true;
+}
+
+bool Parser::acceptOperator(const char* aName)
+{
+	if (!isOperator(aName)) return false;
+	next();
+	return true;
+}
+
+bool Parser::acceptSeparator(const char* aName)
+{
+	if (!isSeparator(aName)) return false;
+	next();
+	return true;
+}
+
+bool Parser::isChannel() const
+{
+	if (done()) return false;
+	const auto pTC = dynamic_cast<const TokenConstant*>(*pos);
+	return pTC && (pTC->getType() == Token::CHANEL);
+}
+
+bool Parser::acceptWord(const char* aWord)
+{
+	if (done()) return false;
+	const auto pTI = dynamic_cast<const TokenIdentifier*>(*pos);
+	if (!pTI || pTI->hasSuffix()) return false;
+
+	const std::string& name = pTI->getName();
+	for (std::size_t i = 0; i < name.size(); ++i) {
+		if (std::toupper(name[i]) != aWord[i]) return false;
+	}
+	if (aWord[name.size()]) return false;
+	next();
+	return true;
+}
+
+bool Parser::channel(Expression& aExpression)
+{
+	if (!isChannel()) return expression(aExpression, Token::INTEGER);
+
+	// The number follows the '#', any number too large is a bad file number when executed.
+	const unsigned long n = std::strtoul(static_cast<const TokenConstant*>(*pos)->getValue().c_str() + 1, nullptr, 10);
+	aExpression = Expression();
+	aExpression.constants.push_back(Value(static_cast<int16_t>(std::min(n, 32767UL))));
+	aExpression.emit(Expression::PUSH_CONSTANT, 0);
+	aExpression.type = Token::INTEGER;
+	runtime.reserve(aExpression.maxDepth);
+	next();
+	return true;
+}
+
+bool Parser::lineNumber(unsigned& aLine)
+{
+	if (done()) return false;
+	const auto pTC = dynamic_cast<const TokenConstant*>(*pos);
+	if (!pTC || (pTC->getType() != Token::INTEGER) || !::lineNumber(pTC->getValue(), aLine)) return false;
+	next();
+	return true;
+}
+
+bool Parser::lineNumber(LineReference& aLine)
+{
+	const Token* token = done() ? nullptr : *pos;
+	if (!lineNumber(aLine.line)) return false;
+	aLine.token = token;
+	return true;
+}
+
+bool Parser::identifier(std::string& aName, Token::type_t& aType)
+{
+	if (done()) return false;
+	const auto pTI = dynamic_cast<const TokenIdentifier*>(*pos);
+	if (!pTI) return false;
+
+	aName = pTI->getName();
+	for (auto& c : aName) c = std::toupper(c);
+	if (pTI->hasSuffix()) {
+		aType = pTI->getType();
+	} else {
+		static const char suffixes[] = { '$', '%', '!', '#' };	// Indexed by Token::type_t.
+		aType = runtime.defaults[aName[0] - 'A'];
+		aName += suffixes[aType];
+	}
+	next();
+	return true;
+}
+
+bool Parser::expression(Expression& aExpression)
+{
+	aExpression = Expression();
+	if (!binary(aExpression, 0, aExpression.type)) return false;
+	runtime.reserve(aExpression.maxDepth);
+	return true;
+}
+
+bool Parser::expression(Expression& aExpression, const Token::type_t aType)
+{
+	if (!expression(aExpression) || !convert(aExpression, aExpression.type, aType, 1)) return false;
+	aExpression.type = aType;
+	return true;
+}
+
+bool Parser::lvalue(Lvalue& aLvalue)
+{
+	std::string name;
+	if (!identifier(name, aLvalue.type)) return false;
+
+	aLvalue.indexes.clear();
+	aLvalue.array = acceptOperator("(");
+	if (!aLvalue.array) {
+		aLvalue.slot = runtime.variable(name, aLvalue.type);
+		return true;
+	}
+
+	aLvalue.slot = runtime.array(name, aLvalue.type);
+	do {
+		Expression index;
+		if (!expression(index, Token::INTEGER)) return false;
+		aLvalue.indexes.push_back(index);
+	} while (acceptSeparator(","));
+	return (aLvalue.indexes.size() <= Expression::MAX_DIMENSIONS) && acceptOperator(")");
+}
+
+bool Parser::convert(Expression& aExpression, const Token::type_t aFrom, const Token::type_t aTo, const unsigned aOffset)
+{
+	static const Expression::opcode_t conversions[3][3] = {	// From INTEGER, SINGLE, DOUBLE to INTEGER, SINGLE, DOUBLE.
+		{ Expression::CALL, Expression::INTEGER_TO_SINGLE, Expression::INTEGER_TO_DOUBLE },
+		{ Expression::SINGLE_TO_INTEGER, Expression::CALL, Expression::SINGLE_TO_DOUBLE },
+		{ Expression::DOUBLE_TO_INTEGER, Expression::DOUBLE_TO_SINGLE, Expression::CALL }
+	};
+
+	if (aFrom == aTo) return true;
+	if ((aFrom == Token::STRING) || (aTo == Token::STRING)) return fail(Error::TYPE_MISMATCH);
+
+	// A constant is converted once here instead of on each evaluation: the operand aOffset places below the top
+	// is one when the last operation pushed it, or for the left operand when the right one was a single push after it.
+	const auto& operations = aExpression.operations;
+	const auto size = operations.size();
+	const Expression::Operation* pPush = nullptr;
+	if ((aOffset == 1) && size) pPush = &operations[size - 1];
+	else if ((aOffset == 2) && (size >= 2) && ((operations[size - 1].code == Expression::PUSH_CONSTANT) || (operations[size - 1].code == Expression::PUSH_VARIABLE))) pPush = &operations[size - 2];
+	if (pPush && (pPush->code == Expression::PUSH_CONSTANT)) {
+		Value converted = aExpression.constants[pPush->arg];
+		// One out of range is left to the run, which reports the overflow when evaluating it as before.
+		if (converted.convert(aTo) == Error::OK) {
+			aExpression.constants[pPush->arg] = converted;
+			return true;
+		}
+	}
+
+	aExpression.emit(conversions[aFrom - Token::INTEGER][aTo - Token::INTEGER], aOffset);
+	return true;
+}
+
+bool Parser::operation(Expression& aExpression, const Expression::opcode_t aCode, const unsigned aArg, Token::type_t& aLeft, const Token::type_t aRight)
+{
+	if ((aLeft == Token::STRING) || (aRight == Token::STRING)) {
+		if (aLeft != aRight) return fail(Error::TYPE_MISMATCH);
+		if (aCode == Expression::ADD_INTEGER) {
+			aExpression.emit(Expression::CONCAT);
+		} else if (aCode == Expression::COMPARE_INTEGER) {
+			aExpression.emit(Expression::COMPARE_STRING, aArg);
+			aLeft = Token::INTEGER;
+		} else return fail(Error::TYPE_MISMATCH);
+		return true;
+	}
+
+	switch (aCode) {
+		case Expression::INTEGER_DIVIDE :
+		case Expression::MODULO :
+		case Expression::AND :
+		case Expression::OR :
+		case Expression::XOR :
+		case Expression::EQV :
+		case Expression::IMP :
+			convert(aExpression, aLeft, Token::INTEGER, 2);
+			convert(aExpression, aRight, Token::INTEGER, 1);
+			aExpression.emit(aCode);
+			aLeft = Token::INTEGER;
+			return true;
+		default : {
+			// Both operands take the most precise type, at least SINGLE for / and ^.
+			const Token::type_t first = (aCode == Expression::DIVIDE_SINGLE) || (aCode == Expression::POWER_SINGLE) ? Token::SINGLE : Token::INTEGER;
+			const Token::type_t type = std::max(first, std::max(aLeft, aRight));
+			convert(aExpression, aLeft, type, 2);
+			convert(aExpression, aRight, type, 1);
+			aExpression.emit(static_cast<Expression::opcode_t>(aCode + type - first), aArg);
+			aLeft = aCode == Expression::COMPARE_INTEGER ? Token::INTEGER : type;
+			return true;
+		}
+	}
+}
+
+bool Parser::binary(Expression& aExpression, const unsigned aLevel, Token::type_t& aType)
+{
+	static const struct {
+		const char* name;
+		Expression::opcode_t code;
+		unsigned arg;
+		unsigned level;
+	} operators[] = {
+		{ "IMP", Expression::IMP, 0, 0 },
+		{ "EQV", Expression::EQV, 0, 1 },
+		{ "XOR", Expression::XOR, 0, 2 },
+		{ "OR", Expression::OR, 0, 3 },
+		{ "AND", Expression::AND, 0, 4 },
+		{ "=", Expression::COMPARE_INTEGER, Expression::EQUAL, 6 },
+		{ "<>", Expression::COMPARE_INTEGER, Expression::NOT_EQUAL, 6 },
+		{ "><", Expression::COMPARE_INTEGER, Expression::NOT_EQUAL, 6 },
+		{ "<", Expression::COMPARE_INTEGER, Expression::LESS, 6 },
+		{ ">", Expression::COMPARE_INTEGER, Expression::GREATER, 6 },
+		{ "<=", Expression::COMPARE_INTEGER, Expression::LESS_EQUAL, 6 },
+		{ "=<", Expression::COMPARE_INTEGER, Expression::LESS_EQUAL, 6 },
+		{ ">=", Expression::COMPARE_INTEGER, Expression::GREATER_EQUAL, 6 },
+		{ "=>", Expression::COMPARE_INTEGER, Expression::GREATER_EQUAL, 6 },
+		{ "+", Expression::ADD_INTEGER, 0, 7 },
+		{ "-", Expression::SUBTRACT_INTEGER, 0, 7 },
+		{ "MOD", Expression::MODULO, 0, 8 },
+		{ "\\", Expression::INTEGER_DIVIDE, 0, 9 },
+		{ "*", Expression::MULTIPLY_INTEGER, 0, 10 },
+		{ "/", Expression::DIVIDE_SINGLE, 0, 10 }
+	};
+
+	Token::type_t right;
+
+	switch (aLevel) {
+		case 5 :	// NOT
+			if (acceptOperator("NOT")) {
+				if (!binary(aExpression, 5, aType) || !convert(aExpression, aType, Token::INTEGER, 1)) return false;
+				aExpression.emit(Expression::NOT);
+				aType = Token::INTEGER;
+				return true;
+			}
+			return binary(aExpression, 6, aType);
+
+		case 11 :	// Unary minus
+			if (acceptOperator("-")) {
+				if (!binary(aExpression, 11, aType)) return false;
+				if (aType == Token::STRING) return fail(Error::TYPE_MISMATCH);
+				aExpression.emit(static_cast<Expression::opcode_t>(Expression::NEGATE_INTEGER + aType - Token::INTEGER));
+				return true;
+			}
+			if (acceptOperator("+")) return binary(aExpression, 11, aType);
+			return binary(aExpression, 12, aType);
+
+		case 12 :	// ^, the exponent may be negated
+			if (!primary(aExpression, aType)) return false;
+			while (acceptOperator("^")) {
+				const bool negate = acceptOperator("-");
+				if (!primary(aExpression, right)) return false;
+				if (negate) {
+					if (right == Token::STRING) return fail(Error::TYPE_MISMATCH);
+					aExpression.emit(static_cast<Expression::opcode_t>(Expression::NEGATE_INTEGER + right - Token::INTEGER));
+				}
+				if (!operation(aExpression, Expression::POWER_SINGLE, 0, aType, right)) return false;
+			}
+			return true;
+
+		default :
+			if (!binary(aExpression, aLevel + 1, aType)) return false;
+			for (;;) {
+				const Expression::opcode_t* code = nullptr;
+				unsigned arg = 0;
+				for (auto&& op : operators) {
+					if ((op.level == aLevel) && isOperator(op.name)) {
+						code = &op.code;
+						arg = op.arg;
+						break;
+					}
+				}
+				if (!code) return true;
+				next();
+				if (!binary(aExpression, aLevel + 1, right) || !operation(aExpression, *code, arg, aType, right)) return false;
+			}
+	}
+}
+
+bool Parser::primary(Expression& aExpression, Token::type_t& aType)
+{
+	if (done()) return false;
+
+	if (const auto pTC = dynamic_cast<const TokenConstant*>(*pos)) {
+		Value value;
+		const auto e = Value::create(*pTC, value);
+		if (e) return fail(e);
+		aType = value.type;
+		aExpression.constants.push_back(value);
+		aExpression.emit(value.isString() ? Expression::PUSH_STRING_CONSTANT : Expression::PUSH_CONSTANT, aExpression.constants.size() - 1);
+		next();
+		return true;
+	}
+
+	if (acceptOperator("(")) {
+		return binary(aExpression, 0, aType) && acceptOperator(")");
+	}
+
+	if (const auto pTF = dynamic_cast<const TokenFunction*>(*pos)) {
+		Expression::function_t function;
+		unsigned min, max;
+		const char* signature;
+		if (!Expression::function(pTF->getString(), function, min, max, signature)) return false;
+		next();
+
+		Token::type_t types[3];
+		unsigned count = 0;
+		if (acceptOperator("(")) {
+			do {
+				if ((count >= max) || !binary(aExpression, 0, types[count])) return false;
+				++count;
+			} while (acceptSeparator(","));
+			if (!acceptOperator(")")) return false;
+		}
+		if ((count < min) || (count > max)) return false;
+
+		// The first argument of INSTR is optional.
+		const char* args = signature + 1 + ((function == Expression::INSTR) && (count < max) ? 1 : 0);
+		for (unsigned i = 0; i < count; ++i) {
+			if ((args[i] == '$') != (types[i] == Token::STRING) && (args[i] != '*')) return fail(Error::TYPE_MISMATCH);
+		}
+
+		switch (signature[0]) {
+			case '%' : aType = Token::INTEGER; break;
+			case '!' : aType = Token::SINGLE; break;
+			case '#' : aType = Token::DOUBLE; break;
+			case '$' : aType = Token::STRING; break;
+			case '=' : aType = types[0]; break;
+			default : aType = types[0] == Token::DOUBLE ? Token::DOUBLE : Token::SINGLE;
+		}
+		aExpression.emit(Expression::CALL, function, count);
+		return true;
+	}
+
+	std::string name;
+	if (identifier(name, aType)) {
+		if (!acceptOperator("(")) {
+			aExpression.emit(aType == Token::STRING ? Expression::PUSH_STRING_VARIABLE : Expression::PUSH_VARIABLE, runtime.variable(name, aType));
+			return true;
+		}
+		unsigned count = 0;
+		do {
+			Token::type_t index;
+			if (!binary(aExpression, 0, index) || !convert(aExpression, index, Token::INTEGER, 1)) return false;
+			++count;
+		} while (acceptSeparator(","));
+		if ((count > Expression::MAX_DIMENSIONS) || !acceptOperator(")")) return false;
+		aExpression.emit(Expression::PUSH_ELEMENT, runtime.array(name, aType), count);
+		return true;
+	}
+
+	return false;
+}
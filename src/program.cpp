@@ -0,0 +1,49 @@
+/**
+ * Copyright [2024] Marc SIBERT
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include "program.h"
+#include "command.h"
+
+void Position::next(const Program& aProgram)
+{
+	if (++index >= line->second.size()) {
+		++line;
+		index = 0;
+		settle(aProgram);
+	}
+}
+
+void Position::settle(const Program& aProgram)
+{
+	while ((line != aProgram.cend()) && line->second.empty()) ++line;
+}
+
+unsigned Position::number() const
+{
+	return line->second[index].getLine();
+}
+
+void LineReference::resolve(const Program& aProgram)
+{
+	resolved = false;
+	if (!line) return;
+
+	position.line = aProgram.find(line);
+	if (position.line == aProgram.cend()) return;
+	position.index = 0;
+	position.settle(aProgram);
+	resolved = true;
+}
@@ -0,0 +1,291 @@
+/**
+ * Copyright [2024] Marc SIBERT
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include "runtime.h"
+#include "snapshot.h"
+
+#include <algorithm>
+#include <iterator>
+
+Runtime::Runtime(std::istream& aIn, std::ostream& aOut, std::ostream& aErr, const unsigned aDepth) :
+	in(aIn),
+	out(aOut),
+	err(aErr),
+	output(&aOut),
+	program(nullptr),
+	control(aDepth),
+	handlingError(false),
+	lastError(Error::OK),
+	errorLine(0),
+	dataPointer(0),
+	column(0),
+	seed(0x50000),
+	lastRandom(0)
+{
+	std::fill(std::begin(defaults), std::end(defaults), Token::SINGLE);
+	std::fill(std::begin(operations), std::end(operations), 0);
+}
+
+unsigned Runtime::variable(const std::string& aName, const Token::type_t aType)
+{
+	const auto it = variableSlots.find(aName);
+	if (it != variableSlots.end()) return it->second;
+
+	variables.push_back(Value::zero(aType));
+	return variableSlots[aName] = variables.size() - 1;
+}
+
+unsigned Runtime::array(const std::string& aName, const Token::type_t aType)
+{
+	const auto it = arraySlots.find(aName);
+	if (it != arraySlots.end()) return it->second;
+
+	Array a;
+	a.type = aType;
+	arrays.push_back(a);
+	return arraySlots[aName] = arrays.size() - 1;
+}
+
+void Runtime::reserve(const unsigned aDepth)
+{
+	if (stack.size() < aDepth) stack.resize(aDepth);
+}
+
+void Runtime::reset()
+{
+	variables.clear();
+	arrays.clear();
+	variableSlots.clear();
+	arraySlots.clear();
+	data.clear();
+	dataLines.clear();
+	std::fill(std::begin(defaults), std::end(defaults), Token::SINGLE);
+}
+
+void Runtime::clear(const Program& aProgram)
+{
+	program = &aProgram;
+	for (auto& v : variables) v = Value::zero(v.type);
+	for (auto& a : arrays) {
+		a.bounds.clear();
+		a.values.clear();
+	}
+	control.clear();
+	errorHandler = LineReference();
+	handlingError = false;
+	lastError = Error::OK;
+	errorLine = 0;
+	dataPointer = 0;
+	pc.line = current.line = program->cbegin();
+	pc.index = current.index = 0;
+	pc.settle(*program);
+	stopped.line = program->cend();
+	stopped.index = 0;
+}
+
+void Runtime::save(std::ostream& aOut) const
+{
+	saveVariables(aOut);
+
+	std::vector<const std::string*> names(variables.size());
+	for (auto&& v : variableSlots) names[v.second] = &v.first;
+	Snapshot::put(aOut, control.size());
+	for (unsigned i = 0; i < control.size(); ++i) {
+		const Frame& frame = control[i];
+		Snapshot::put(aOut, frame.kind);
+		Snapshot::put(aOut, *program, frame.back);
+		if (frame.kind == Frame::FOR) {
+			Snapshot::put(aOut, *names[frame.variable]);
+			Snapshot::put(aOut, frame.limit);
+			Snapshot::put(aOut, frame.step);
+		}
+	}
+
+	// After a STOP, the run goes on with the command following it.
+	Snapshot::put(aOut, *program, pc.line == program->cend() ? stopped : pc);
+	Snapshot::put(aOut, errorHandler.line);
+	Snapshot::put(aOut, handlingError);
+	if (handlingError) {
+		Snapshot::put(aOut, lastError);
+		Snapshot::put(aOut, errorLine);
+		Snapshot::put(aOut, *program, errorPosition);
+	}
+	Snapshot::put(aOut, dataPointer);
+	Snapshot::put(aOut, column);
+	Snapshot::put(aOut, seed);
+	Snapshot::put(aOut, Value(lastRandom));
+}
+
+Error::error_t Runtime::restore(std::istream& aIn)
+{
+	auto error = restoreVariables(aIn);
+	if (error) return error;
+
+	uint32_t count, kind, line, flag, code, number;
+	if (!Snapshot::get(aIn, count) || (count > control.capacity())) return Error::BAD_FILE_MODE;
+	control.clear();
+	for (unsigned i = 0; i < count; ++i) {
+		if (!Snapshot::get(aIn, kind) || (kind > Frame::WHILE)) return Error::BAD_FILE_MODE;
+		Frame* frame = control.push(static_cast<Frame::kind_t>(kind));
+		if (!Snapshot::get(aIn, *program, frame->back)) return Error::BAD_FILE_MODE;
+		if (kind == Frame::FOR) {
+			std::string name;
+			if (!Snapshot::get(aIn, name) || !Snapshot::get(aIn, frame->limit) || !Snapshot::get(aIn, frame->step)) return Error::BAD_FILE_MODE;
+			frame->variable = variable(name, frame->limit.type);
+		}
+	}
+
+	Value random;
+	if (!Snapshot::get(aIn, *program, pc) || !Snapshot::get(aIn, line) || !Snapshot::get(aIn, flag)) return Error::BAD_FILE_MODE;
+	errorHandler = LineReference(line);
+	errorHandler.resolve(*program);
+	handlingError = flag;
+	if (handlingError) {
+		if (!Snapshot::get(aIn, code) || !Snapshot::get(aIn, number) || !Snapshot::get(aIn, *program, errorPosition)) return Error::BAD_FILE_MODE;
+		lastError = static_cast<Error::error_t>(code);
+		errorLine = number;
+	}
+	if (!Snapshot::get(aIn, dataPointer) || !Snapshot::get(aIn, column) || !Snapshot::get(aIn, seed) || !Snapshot::get(aIn, random)) return Error::BAD_FILE_MODE;
+	lastRandom = random.single;
+	return dataPointer <= data.size() ? Error::OK : Error::BAD_FILE_MODE;
+}
+
+void Runtime::saveVariables(std::ostream& aOut, const std::set<unsigned>* aVariables, const std::set<unsigned>* aArrays) const
+{
+	Snapshot::put(aOut, aVariables ? aVariables->size() : variableSlots.size());
+	for (auto&& v : variableSlots) {
+		if (aVariables && !aVariables->count(v.second)) continue;
+		Snapshot::put(aOut, v.first);
+		Snapshot::put(aOut, variables[v.second]);
+	}
+
+	unsigned count = 0;
+	for (auto&& a : arraySlots) {
+		if ((!aArrays || aArrays->count(a.second)) && !arrays[a.second].bounds.empty()) ++count;
+	}
+	Snapshot::put(aOut, count);
+	for (auto&& a : arraySlots) {
+		const Array& array = arrays[a.second];
+		if ((aArrays && !aArrays->count(a.second)) || array.bounds.empty()) continue;
+		Snapshot::put(aOut, a.first);
+		Snapshot::put(aOut, array.type);
+		Snapshot::put(aOut, array.bounds.size());
+		for (auto b : array.bounds) Snapshot::put(aOut, b);
+		for (auto&& value : array.values) Snapshot::put(aOut, value);
+	}
+}
+
+Error::error_t Runtime::restoreVariables(std::istream& aIn)
+{
+	uint32_t count, type, dimensions;
+	std::string name;
+	Value value;
+
+	if (!Snapshot::get(aIn, count)) return Error::BAD_FILE_MODE;
+	for (unsigned i = 0; i < count; ++i) {
+		if (!Snapshot::get(aIn, name) || !Snapshot::get(aIn, value)) return Error::BAD_FILE_MODE;
+		variables[variable(name, value.type)] = value;
+	}
+
+	if (!Snapshot::get(aIn, count)) return Error::BAD_FILE_MODE;
+	for (unsigned i = 0; i < count; ++i) {
+		if (!Snapshot::get(aIn, name) || !Snapshot::get(aIn, type) || (type > Token::DOUBLE) || !Snapshot::get(aIn, dimensions) || (dimensions > Expression::MAX_DIMENSIONS)) return Error::BAD_FILE_MODE;
+		std::vector<unsigned> bounds(dimensions);
+		for (auto& b : bounds) {
+			uint32_t bound;
+			if (!Snapshot::get(aIn, bound) || (bound > 32767)) return Error::BAD_FILE_MODE;
+			b = bound;
+		}
+		const unsigned slot = array(name, static_cast<Token::type_t>(type));
+		arrays[slot].bounds.clear();
+		// The bounds of a corrupted snapshot may ask for more memory than there is.
+		if (dimension(slot, bounds)) return Error::BAD_FILE_MODE;
+		for (auto& v : arrays[slot].values) {
+			if (!Snapshot::get(aIn, v)) return Error::BAD_FILE_MODE;
+		}
+	}
+	return Error::OK;
+}
+
+Error::error_t Runtime::jump(const unsigned aLine)
+{
+	const auto it = program->find(aLine);
+	if (it == program->cend()) return Error::LINE_NOT_FOUND;
+	pc.line = it;
+	pc.index = 0;
+	pc.settle(*program);
+	return Error::OK;
+}
+
+bool Runtime::trap(const Error::error_t aError)
+{
+	if (!errorHandler.line || handlingError) return false;
+
+	lastError = aError;
+	errorLine = current.number();
+	errorPosition = current;
+	handlingError = true;
+	pc = errorHandler.position;
+	return true;
+}
+
+Error::error_t Runtime::dimension(const unsigned aArray, const std::vector<unsigned>& aBounds)
+{
+	Array& a = arrays[aArray];
+	if (!a.bounds.empty()) return Error::DUPLICATE_DEFINITION;
+
+	// Checked on each dimension, the product of up to 8 bounds of 32767 overflowing.
+	std::size_t size = 1;
+	for (auto b : aBounds) {
+		size *= b + 1;
+		if (size > ARRAY_ELEMENTS) return Error::OUT_OF_MEMORY;
+	}
+	a.bounds = aBounds;
+	a.values.assign(size, Value::zero(a.type));
+	return Error::OK;
+}
+
+Error::error_t Runtime::element(const unsigned aArray, const int16_t* aIndexes, const unsigned aCount, Value*& aElement)
+{
+	Array& a = arrays[aArray];
+	if (a.bounds.empty()) {
+		const auto error = dimension(aArray, std::vector<unsigned>(aCount, 10));
+		if (error) return error;
+	}
+	if (aCount != a.bounds.size()) return Error::SUBSCRIPT_OUT_OF_RANGE;
+
+	std::size_t offset = 0;
+	for (unsigned i = 0; i < aCount; ++i) {
+		if ((aIndexes[i] < 0) || (static_cast<unsigned>(aIndexes[i]) > a.bounds[i])) return Error::SUBSCRIPT_OUT_OF_RANGE;
+		offset = offset * (a.bounds[i] + 1) + aIndexes[i];
+	}
+	aElement = &a.values[offset];
+	return Error::OK;
+}
+
+void Runtime::print(const char* aText, const std::size_t aSize)
+{
+	output->write(aText, aSize);
+	std::size_t nl = aSize;
+	while (nl && (aText[nl - 1] != '\n')) --nl;
+	column = nl ? aSize - nl : column + aSize;
+}
+
+float Runtime::random()
+{
+	seed = seed * 214013 + 2531011;
+	return lastRandom = static_cast<float>((seed >> 8) & 0xFFFFFF) / 16777216.0f;
+}
@@ -0,0 +1,164 @@
+/**
+ * Copyright [2024] Marc SIBERT
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include "snapshot.h"
+#include "command.h"
+#include "statements.h"
+
+#include <cstring>
+
+void Snapshot::put(std::ostream& aOut, const uint32_t aValue)
+{
+	const char bytes[] = {
+		static_cast<char>(aValue), static_cast<char>(aValue >> 8), static_cast<char>(aValue >> 16), static_cast<char>(aValue >> 24)
+	};
+	aOut.write(bytes, sizeof(bytes));
+}
+
+void Snapshot::put(std::ostream& aOut, const std::string& aString)
+{
+	put(aOut, static_cast<uint32_t>(aString.size()));
+	aOut.write(aString.data(), aString.size());
+}
+
+void Snapshot::put(std::ostream& aOut, const Value& aValue)
+{
+	put(aOut, static_cast<uint32_t>(aValue.type));
+	switch (aValue.type) {
+		case Token::INTEGER :
+			put(aOut, static_cast<uint16_t>(aValue.integer));
+			break;
+		case Token::SINGLE : {
+			uint32_t bits;
+			std::memcpy(&bits, &aValue.single, sizeof(bits));
+			put(aOut, bits);
+			break;
+		}
+		case Token::DOUBLE : {
+			uint64_t bits;
+			std::memcpy(&bits, &aValue.dbl, sizeof(bits));
+			put(aOut, static_cast<uint32_t>(bits));
+			put(aOut, static_cast<uint32_t>(bits >> 32));
+			break;
+		}
+		default :
+			put(aOut, aValue.string);
+	}
+}
+
+void Snapshot::put(std::ostream& aOut, const Program& aProgram, const Position& aPosition)
+{
+	if (aPosition.line == aProgram.cend()) {
+		put(aOut, 0);
+		return;
+	}
+
+	const unsigned number = aPosition.number();
+	uint32_t rank = 0;
+	for (unsigned i = 0; i < aPosition.index; ++i) {
+		const Command& command = aPosition.line->second[i];
+		if ((command.getLine() == number) && !dynamic_cast<const StatementRem*>(command.getStatement())) ++rank;
+	}
+	put(aOut, 1);
+	put(aOut, number);
+	put(aOut, rank);
+}
+
+bool Snapshot::get(std::istream& aIn, uint32_t& aValue)
+{
+	unsigned char bytes[4];
+	if (!aIn.read(reinterpret_cast<char*>(bytes), sizeof(bytes))) return false;
+	aValue = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+	return true;
+}
+
+bool Snapshot::get(std::istream& aIn, std::string& aString)
+{
+	uint32_t size;
+	if (!get(aIn, size)) return false;
+	aString.resize(size);
+	return size ? static_cast<bool>(aIn.read(&aString[0], size)) : true;
+}
+
+bool Snapshot::get(std::istream& aIn, Value& aValue)
+{
+	uint32_t type, bits, high;
+	if (!get(aIn, type)) return false;
+	switch (type) {
+		case Token::INTEGER :
+			if (!get(aIn, bits)) return false;
+			aValue = Value(static_cast<int16_t>(bits));
+			return true;
+		case Token::SINGLE : {
+			if (!get(aIn, bits)) return false;
+			float f;
+			std::memcpy(&f, &bits, sizeof(f));
+			aValue = Value(f);
+			return true;
+		}
+		case Token::DOUBLE : {
+			if (!get(aIn, bits) || !get(aIn, high)) return false;
+			const uint64_t all = bits | (static_cast<uint64_t>(high) << 32);
+			double d;
+			std::memcpy(&d, &all, sizeof(d));
+			aValue = Value(d);
+			return true;
+		}
+		case Token::STRING :
+			aValue = Value::zero(Token::STRING);
+			return get(aIn, aValue.string);
+		default :
+			return false;
+	}
+}
+
+bool Snapshot::get(std::istream& aIn, const Program& aProgram, Position& aPosition)
+{
+	uint32_t valid, number, rank;
+	if (!get(aIn, valid)) return false;
+	aPosition.index = 0;
+	if (!valid) {
+		aPosition.line = aProgram.cend();
+		return true;
+	}
+	if (!get(aIn, number) || !get(aIn, rank)) return false;
+
+	// The line may have been appended to a previous one by the optimized load.
+	auto itLine = aProgram.upper_bound(number);
+	if (itLine == aProgram.cbegin()) return false;
+	--itLine;
+	if (!itLine->second.empty()) {
+		if (const auto pLazy = dynamic_cast<const StatementLazy*>(itLine->second[0].getStatement())) {
+			if (pLazy->getSource().expand(itLine)) return false;
+		}
+	}
+
+	aPosition.line = itLine;
+	for (unsigned i = 0; i < itLine->second.size(); ++i) {
+		const Command& command = itLine->second[i];
+		if (command.getLine() < number) continue;
+		// Past the commands of the line, which only held REM dropped by the optimized load.
+		if ((command.getLine() > number) || !rank) {
+			aPosition.index = i;
+			return true;
+		}
+		if (!dynamic_cast<const StatementRem*>(command.getStatement())) --rank;
+	}
+	++aPosition.line;
+	aPosition.index = 0;
+	aPosition.settle(aProgram);
+	return true;
+}
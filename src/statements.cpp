@@ -0,0 +1,1592 @@
+/**
+ * Copyright [2024] Marc SIBERT
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include "statements.h"
+#include "parser.h"
+#include "runtime.h"
+#include "tokenizer.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <iterator>
+#include <sstream>
+
+namespace {
+
+template<class T> Statement* make(Parser& aParser)
+{
+	return T::create(aParser);
+}
+
+template<Token::type_t T> Statement* deftype(Parser& aParser)
+{
+	return StatementDeftype::create(aParser, T);
+}
+
+template<bool P> Statement* getput(Parser& aParser)
+{
+	return StatementGet::create(aParser, P);
+}
+
+template<bool R> Statement* lset(Parser& aParser)
+{
+	return StatementLset::create(aParser, R);
+}
+
+template<bool L> Statement* input(Parser& aParser)
+{
+	return StatementInput::create(aParser, L);
+}
+
+/**
+ * LINE INPUT, LINE drawing being unsupported.
+ **/
+Statement* line(Parser& aParser)
+{
+	if (aParser.acceptInstruction("INPUT")) return input<true>(aParser);
+	aParser.skip();
+	return new StatementUnsupported();
+}
+
+/**
+ * CHAIN, CHAIN MERGE being unsupported.
+ **/
+Statement* chain(Parser& aParser)
+{
+	if (!aParser.isInstruction("MERGE")) return StatementChain::create(aParser);
+	aParser.skip();
+	return new StatementUnsupported();
+}
+
+/**
+ * ON ERROR GOTO or ON n GOTO|GOSUB.
+ **/
+Statement* on(Parser& aParser)
+{
+	if (aParser.acceptInstruction("ERROR")) return StatementOnError::create(aParser);
+	return StatementOn::create(aParser);
+}
+
+bool finished(const Value& aVariable, const Frame& aFrame)
+{
+	return aFrame.step.toDouble() >= 0 ? aVariable.toDouble() > aFrame.limit.toDouble()
+	                                   : aVariable.toDouble() < aFrame.limit.toDouble();
+}
+
+/**
+ * Find the command following the end of a block (the NEXT of a FOR, the WEND of a WHILE), skipping the nested blocks.
+ * @param aPosition Position of the start of the block, then of the command following its end.
+ * @return false if the block has no end.
+ **/
+template<class Start, class End> bool skipBlock(const Program& aProgram, Position& aPosition, unsigned (*aClosed)(const End&))
+{
+	unsigned depth = 0;
+	for (aPosition.next(aProgram); aPosition.line != aProgram.cend(); aPosition.next(aProgram)) {
+		const Statement* s = aPosition.line->second[aPosition.index].getStatement();
+		if (const auto pLazy = dynamic_cast<const StatementLazy*>(s)) {
+			// The block goes on in a line not compiled yet.
+			if (!pLazy->getSource().expand(aPosition.line)) s = aPosition.line->second[aPosition.index].getStatement();
+		}
+		if (dynamic_cast<const Start*>(s)) {
+			++depth;
+		} else if (const auto pEnd = dynamic_cast<const End*>(s)) {
+			const unsigned closed = aClosed(*pEnd);
+			if (closed > depth) {
+				aPosition.next(aProgram);
+				return true;
+			}
+			depth -= closed;
+		}
+	}
+	return false;
+}
+
+/**
+ * Number of loops closed by a NEXT: "NEXT I, J" closes two.
+ **/
+unsigned nextClosed(const StatementNext& aNext)
+{
+	return aNext.getVariables().empty() ? 1 : aNext.getVariables().size();
+}
+
+unsigned wendClosed(const StatementWend&)
+{
+	return 1;
+}
+
+/**
+ * Find the file open on the channel of a statement.
+ * @param aModes Modes allowed, as bits (1 << File::INPUT...), BAD_FILE_MODE otherwise.
+ **/
+Error::error_t channelFile(Runtime& aRuntime, const Expression& aChannel, const unsigned aModes, File*& aFile)
+{
+	int16_t n;
+	auto error = aChannel.evaluate(aRuntime, n);
+	if (!error) error = aRuntime.files.get(n, aFile);
+	if (error) return error;
+	return (aModes & (1 << aFile->mode)) ? Error::OK : Error::BAD_FILE_MODE;
+}
+
+}
+
+Statement* Statement::create(Parser& aParser)
+{
+	static const struct {
+		const char* name;
+		Statement* (*create)(Parser&);
+	} statements[] = {
+		{ "CHAIN", chain },
+		{ "CLOSE", make<StatementClose> },
+		{ "CLS", make<StatementRem> },		// No screen to clear.
+		{ "COMMON", make<StatementCommon> },
+		{ "DATA", make<StatementData> },
+		{ "DEFDBL", deftype<Token::DOUBLE> },
+		{ "DEFINT", deftype<Token::INTEGER> },
+		{ "DEFSNG", deftype<Token::SINGLE> },
+		{ "DEFSTR", deftype<Token::STRING> },
+		{ "DIM", make<StatementDim> },
+		{ "END", make<StatementEnd> },
+		{ "ERROR", make<StatementError> },
+		{ "FIELD", make<StatementField> },
+		{ "FOR", make<StatementFor> },
+		{ "GET", getput<false> },
+		{ "GOSUB", make<StatementGosub> },
+		{ "GOTO", make<StatementGoto> },
+		{ "IF", make<StatementIf> },
+		{ "INPUT", input<false> },
+		{ "LET", make<StatementLet> },
+		{ "LINE", line },
+		{ "LSET", lset<false> },
+		{ "NEXT", make<StatementNext> },
+		{ "ON", on },
+		{ "OPEN", make<StatementOpen> },
+		{ "PRINT", make<StatementPrint> },
+		{ "PUT", getput<true> },
+		{ "RANDOMIZE", make<StatementRandomize> },
+		{ "READ", make<StatementRead> },
+		{ "RESTORE", make<StatementRestore> },
+		{ "RESUME", make<StatementResume> },
+		{ "RETURN", make<StatementReturn> },
+		{ "RSET", lset<true> },
+		{ "STOP", make<StatementStop> },
+		{ "WEND", make<StatementWend> },
+		{ "WHILE", make<StatementWhile> }
+	};
+
+	Statement* statement = nullptr;
+
+	if (aParser.atEnd() || dynamic_cast<const TokenComment*>(aParser.current())) {
+		statement = StatementRem::create(aParser);
+	} else if (const auto pTI = dynamic_cast<const TokenInstruction*>(aParser.current())) {
+		const auto it = std::find_if(std::begin(statements), std::end(statements), [pTI](decltype(statements[0]) s) {
+			return pTI->getString() == s.name;
+		});
+		if (it == std::end(statements)) {
+			aParser.skip();
+			return new StatementUnsupported();
+		}
+		if (pTI->getString() != "LET") aParser.next();
+		statement = it->create(aParser);
+	} else if (dynamic_cast<const TokenIdentifier*>(aParser.current())) {
+		statement = StatementLet::create(aParser);
+	}
+
+	if (statement && !aParser.atEnd()) {
+		delete statement;
+		return nullptr;
+	}
+	return statement;
+}
+
+
+StatementRem* StatementRem::create(Parser& aParser)
+{
+	if (!aParser.done() && dynamic_cast<const TokenComment*>(aParser.current())) aParser.next();
+	return new StatementRem();
+}
+
+Error::error_t StatementRem::execute(Runtime&) const
+{
+	return Error::OK;
+}
+
+
+Error::error_t StatementUnsupported::execute(Runtime&) const
+{
+	return Error::ADVANCED_FEATURE;
+}
+
+
+Error::error_t StatementLazy::execute(Runtime&) const
+{
+	return Error::UNCOMPILED;
+}
+
+Error::error_t StatementLazy::compile(const unsigned aLine, std::vector<Command>& aCommands) const
+{
+	Runtime& runtime = source.runtime;
+
+	Tokenizer tokenizer;
+	bool failed;
+	int column;
+	const auto tokens = tokenizer.tokenize(getText(), failed, column);
+	if (failed) return Error::SYNTAX_ERROR;
+
+	// The types of the variables are the ones of this point of the file, not of the point the run reached.
+	std::array<Token::type_t, 26> types;
+	std::copy(std::begin(runtime.defaults), std::end(runtime.defaults), types.begin());
+	std::copy(source.defaults[defaults].cbegin(), source.defaults[defaults].cend(), std::begin(runtime.defaults));
+
+	aCommands.clear();
+	Error::error_t error = Error::OK;
+	for (auto itToken = tokens.cbegin(); !error && (itToken != tokens.cend()); ) {
+		aCommands.push_back(Command::slice(itToken, tokens.cend(), aLine));
+		error = aCommands.back().compile(runtime);
+	}
+	std::copy(types.cbegin(), types.cend(), std::begin(runtime.defaults));
+	if (error) {
+		aCommands.clear();
+		for (auto&& token : tokens) delete token;
+	}
+	return error;
+}
+
+Error::error_t LazySource::expand(const Program::const_iterator& aLine)
+{
+	const auto pLazy = aLine->second.empty() ? nullptr : dynamic_cast<const StatementLazy*>(aLine->second[0].getStatement());
+	if (!pLazy) return Error::OK;
+
+	std::vector<Command> commands;
+	const auto error = pLazy->compile(aLine->first, commands);
+	if (error) return error;
+
+	// The commands of a line are a cache of its text: filling it leaves the program the same.
+	// The StatementLazy leaves with commands, once the line no longer holds it.
+	const auto itLine = program.find(aLine->first);
+	itLine->second.swap(commands);
+	for (unsigned i = 0; i < itLine->second.size(); ++i) {
+		const Position position = { itLine, i };
+		itLine->second[i].link(program, position);
+	}
+	return Error::OK;
+}
+
+
+bool StatementLazy::renumber(const Renumbering& aNumbers, std::string& aText) const
+{
+	static const char* const jumps[] = { "GOTO", "GOSUB", "THEN", "ELSE", "RESTORE", "RESUME", "RETURN" };
+
+	const std::string text = getText();
+	bool changed = false;
+	bool expected = false;			// A line number may come next.
+	aText.clear();
+	for (std::size_t i = 0; i < text.size(); ) {
+		const char c = text[i];
+		if (c == '"') {
+			const auto close = text.find('"', i + 1);
+			const auto stop = close == std::string::npos ? text.size() : close + 1;
+			aText.append(text, i, stop - i);
+			i = stop;
+			expected = false;
+		} else if (c == '\'') {
+			aText.append(text, i, std::string::npos);
+			break;
+		} else if (std::isalpha(static_cast<unsigned char>(c))) {
+			auto stop = i;
+			std::string word;
+			while ((stop < text.size()) && std::isalpha(static_cast<unsigned char>(text[stop]))) word += std::toupper(static_cast<unsigned char>(text[stop++]));
+			if (!word.compare(0, 3, "REM")) {
+				aText.append(text, i, std::string::npos);
+				break;
+			}
+			aText.append(text, i, stop - i);
+			expected = std::find_if(std::begin(jumps), std::end(jumps), [&word](const char* aJump) { return word == aJump; }) != std::end(jumps);
+			i = stop;
+		} else if (expected && std::isdigit(static_cast<unsigned char>(c))) {
+			auto stop = text.find_first_not_of("0123456789", i);
+			if (stop == std::string::npos) stop = text.size();
+			unsigned number;
+			if (lineNumber(text.substr(i, stop - i), number) && renumbered(aNumbers, number, number)) {
+				aText += std::to_string(number);
+				changed = true;
+			} else aText.append(text, i, stop - i);
+			// ON ... GOTO and ON ... GOSUB are followed by a list of lines.
+			i = stop;
+			while ((i < text.size()) && (text[i] == ' ')) aText += text[i++];
+			expected = (i < text.size()) && (text[i] == ',');
+			if (expected) aText += text[i++];
+		} else {
+			expected = expected && (c == ' ');
+			aText += c;
+			++i;
+		}
+	}
+	if (!changed) aText.clear();
+	return changed;
+}
+
+
+StatementLet* StatementLet::create(Parser& aParser)
+{
+	aParser.acceptInstruction("LET");
+
+	StatementLet s;
+	if (!aParser.lvalue(s.target) || !aParser.acceptOperator("=") || !aParser.expression(s.value, s.target.type)) return nullptr;
+	return new StatementLet(s);
+}
+
+Error::error_t StatementLet::execute(Runtime& aRuntime) const
+{
+	Value v;
+	const auto error = value.evaluate(aRuntime, v);
+	if (error) return error;
+	return target.assign(aRuntime, v);
+}
+
+
+StatementPrint* StatementPrint::create(Parser& aParser)
+{
+	StatementPrint s;
+	s.formatted = false;
+	s.formatError = Error::OK;
+
+	if (aParser.isChannel() && (!aParser.channel(s.channel) || (!aParser.atEnd() && !aParser.acceptSeparator(",")))) return nullptr;
+
+	if (aParser.acceptWord("USING")) {
+		s.formatted = true;
+		if (!aParser.expression(s.formatExpression, Token::STRING) || !aParser.acceptSeparator(";")) return nullptr;
+		// A literal format is compiled once, its errors reported when executing as in GW-BASIC.
+		if (const auto pFormat = s.formatExpression.constant()) {
+			s.formatError = s.format.compile(pFormat->string);
+			s.formatExpression = Expression();
+		} else {
+			s.formatError = Error::ILLEGAL_FUNCTION_CALL;
+		}
+
+		do {
+			Item item;
+			item.kind = Item::EXPRESSION;
+			item.separator = 0;
+			if (!aParser.expression(item.expression)) return nullptr;
+			if (aParser.acceptSeparator(";")) item.separator = ';';
+			else if (aParser.acceptSeparator(",")) item.separator = ',';
+			s.items.push_back(item);
+		} while (!aParser.atEnd());
+		return new StatementPrint(s);
+	}
+
+	while (!aParser.atEnd()) {
+		Item item;
+		item.kind = Item::NONE;
+		item.separator = 0;
+
+		const auto pTF = dynamic_cast<const TokenFunction*>(aParser.current());
+		if (pTF && ((pTF->getString() == "TAB") || (pTF->getString() == "SPC"))) {
+			item.kind = pTF->getString() == "TAB" ? Item::TAB : Item::SPC;
+			aParser.next();
+			if (!aParser.acceptOperator("(") || !aParser.expression(item.expression, Token::INTEGER) || !aParser.acceptOperator(")")) return nullptr;
+		} else if (!aParser.isSeparator(";") && !aParser.isSeparator(",")) {
+			item.kind = Item::EXPRESSION;
+			if (!aParser.expression(item.expression)) return nullptr;
+		}
+
+		if (aParser.acceptSeparator(";")) item.separator = ';';
+		else if (aParser.acceptSeparator(",")) item.separator = ',';
+		s.items.push_back(item);
+	}
+	return new StatementPrint(s);
+}
+
+Error::error_t StatementPrint::execute(Runtime& aRuntime) const
+{
+	if (channel.empty()) return print(aRuntime);
+
+	File* f;
+	auto error = channelFile(aRuntime, channel, (1 << File::OUTPUT) | (1 << File::APPEND), f);
+	if (error) return error;
+
+	// The console output and column are the ones of the file meanwhile.
+	aRuntime.output = &f->stream;
+	std::swap(aRuntime.column, f->column);
+	error = print(aRuntime);
+	std::swap(aRuntime.column, f->column);
+	aRuntime.output = &aRuntime.out;
+	return (error || f->stream) ? error : Error::DEVICE_IO_ERROR;
+}
+
+Error::error_t StatementPrint::print(Runtime& aRuntime) const
+{
+	if (formatted) return printUsing(aRuntime);
+
+	for (auto&& item : items) {
+		Value v;
+		int16_t n;
+		Error::error_t error = Error::OK;
+
+		switch (item.kind) {
+			case Item::EXPRESSION :
+				error = item.expression.evaluate(aRuntime, v);
+				if (error) return error;
+				aRuntime.print(v.isString() ? v.string : v.toString() + ' ');
+				break;
+			case Item::TAB :
+				error = item.expression.evaluate(aRuntime, n);
+				if (error) return error;
+				if ((n < 1) || (n > 255)) return Error::ILLEGAL_FUNCTION_CALL;
+				if (aRuntime.column >= static_cast<unsigned>(n)) aRuntime.newline();
+				aRuntime.print(std::string(n - 1 - aRuntime.column, ' '));
+				break;
+			case Item::SPC :
+				error = item.expression.evaluate(aRuntime, n);
+				if (error) return error;
+				if ((n < 0) || (n > 255)) return Error::ILLEGAL_FUNCTION_CALL;
+				aRuntime.print(std::string(n, ' '));
+				break;
+			default :
+				break;
+		}
+
+		if (item.separator == ',') {
+			if (aRuntime.column >= 70) aRuntime.newline();
+			else aRuntime.print(std::string(14 - aRuntime.column % 14, ' '));
+		}
+	}
+
+	if (items.empty() || !items.back().separator) aRuntime.newline();
+	return Error::OK;
+}
+
+Error::error_t StatementPrint::printUsing(Runtime& aRuntime) const
+{
+	if (!formatExpression.empty()) {
+		Value text;
+		const auto error = formatExpression.evaluate(aRuntime, text);
+		if (error) return error;
+		if (text.string != formatText) {
+			formatText.swap(text.string);
+			formatError = format.compile(formatText);
+		}
+	}
+	if (formatError) return formatError;
+
+	unsigned next = 0;
+	for (auto&& item : items) {
+		Value v;
+		auto error = item.expression.evaluate(aRuntime, v);
+		if (!error) error = format.print(aRuntime, v, next);
+		if (error) return error;
+	}
+	format.finish(aRuntime, next);
+
+	if (!items.back().separator) aRuntime.newline();
+	return Error::OK;
+}
+
+
+StatementInput* StatementInput::create(Parser& aParser, const bool aLine)
+{
+	StatementInput s;
+	s.question = !aLine;
+	s.line = aLine;
+
+	if (aParser.isChannel()) {
+		if (!aParser.channel(s.channel) || !aParser.acceptSeparator(",")) return nullptr;
+	} else if (!aParser.done()) {
+		const auto pTC = dynamic_cast<const TokenConstant*>(aParser.current());
+		if (pTC && (pTC->getType() == Token::STRING)) {
+			s.prompt = pTC->getValue();
+			aParser.next();
+			if (aParser.acceptSeparator(",")) s.question = false;
+			else if (!aParser.acceptSeparator(";")) return nullptr;
+		}
+	}
+
+	do {
+		Lvalue target;
+		if (!aParser.lvalue(target)) return nullptr;
+		s.targets.push_back(target);
+	} while (!aLine && aParser.acceptSeparator(","));
+	if (aLine && (s.targets[0].type != Token::STRING)) {
+		aParser.fail(Error::TYPE_MISMATCH);
+		return nullptr;
+	}
+	return new StatementInput(s);
+}
+
+Error::error_t StatementInput::execute(Runtime& aRuntime) const
+{
+	if (!channel.empty()) {
+		File* f;
+		const auto error = channelFile(aRuntime, channel, 1 << File::INPUT, f);
+		return error ? error : read(aRuntime, *f);
+	}
+
+	for (;;) {
+		aRuntime.print(question ? prompt + "? " : prompt);
+		aRuntime.out.flush();
+
+		std::string line;
+		if (!std::getline(aRuntime.in, line)) return Error::INPUT_PAST_END;
+		if (!line.empty() && (line.back() == '\r')) line.pop_back();
+		aRuntime.column = 0;
+		if (this->line) return targets[0].assign(aRuntime, Value(line));
+
+		// Split the fields, commas inside quotes do not count.
+		std::vector<std::string> fields(1);
+		std::vector<bool> quoted(1, false);
+		bool inQuotes = false;
+		for (auto c : line) {
+			if (c == '"') {
+				inQuotes = !inQuotes;
+				quoted.back() = true;
+			} else if ((c == ',') && !inQuotes) {
+				fields.push_back(std::string());
+				quoted.push_back(false);
+			} else fields.back() += c;
+		}
+
+		bool redo = fields.size() != targets.size();
+		std::vector<Value> values;
+		for (unsigned i = 0; !redo && (i < fields.size()); ++i) {
+			std::string& f = fields[i];
+			if (!quoted[i]) {
+				f.erase(0, f.find_first_not_of(" \t"));
+				f.erase(f.find_last_not_of(" \t") + 1);
+			}
+			if (targets[i].type == Token::STRING) {
+				values.push_back(Value(f));
+			} else {
+				std::istringstream s(f);
+				double d;
+				redo = quoted[i] || (!f.empty() && (!(s >> d) || !s.eof()));
+				values.push_back(Value::parse(f));
+			}
+		}
+
+		if (redo) {
+			aRuntime.print("?Redo from start");
+			aRuntime.newline();
+			continue;
+		}
+
+		for (unsigned i = 0; i < targets.size(); ++i) {
+			const auto error = targets[i].assign(aRuntime, values[i]);
+			if (error) return error;
+		}
+		return Error::OK;
+	}
+}
+
+Error::error_t StatementInput::read(Runtime& aRuntime, File& aFile) const
+{
+	typedef std::istream::traits_type traits;
+	std::istream& in = aFile.stream;
+	std::string item;
+
+	if (line) {
+		if (in.peek() == traits::eof()) return Error::INPUT_PAST_END;
+		std::getline(in, item);
+		if (!item.empty() && (item.back() == '\r')) item.pop_back();
+		return targets[0].assign(aRuntime, Value(item));
+	}
+
+	for (auto&& target : targets) {
+		int c;
+		do c = in.get(); while ((c == ' ') || (c == '\t') || (c == '\r') || (c == '\n'));
+		if (c == traits::eof()) return Error::INPUT_PAST_END;
+
+		item.clear();
+		if (c == '"') {
+			for (c = in.get(); (c != traits::eof()) && (c != '"'); c = in.get()) item += static_cast<char>(c);
+			while ((c != traits::eof()) && (c != ',') && (c != '\n')) c = in.get();
+		} else {
+			// A number also ends with a space, the delimiter following it is then skipped too.
+			const bool number = target.type != Token::STRING;
+			for (; (c != traits::eof()) && (c != ',') && (c != '\n') && !(number && (c == ' ')); c = in.get()) item += static_cast<char>(c);
+			item.erase(item.find_last_not_of(" \t\r") + 1);
+			if (c == ' ') {
+				while ((in.peek() == ' ') || (in.peek() == '\r')) in.get();
+				if ((in.peek() == ',') || (in.peek() == '\n')) in.get();
+			}
+		}
+
+		const auto error = target.assign(aRuntime, target.type == Token::STRING ? Value(item) : Value::parse(item));
+		if (error) return error;
+	}
+	return Error::OK;
+}
+
+
+bool StatementIf::branch(Parser& aParser, LineReference& aLine, std::unique_ptr<Statement>& aStatement)
+{
+	if (aParser.lineNumber(aLine)) return true;
+	aStatement.reset(Statement::create(aParser));
+	return aStatement.get() != nullptr;
+}
+
+StatementIf* StatementIf::create(Parser& aParser)
+{
+	std::unique_ptr<StatementIf> s(new StatementIf());
+
+	if (!aParser.expression(s->condition)) return nullptr;
+	if (s->condition.getType() == Token::STRING) {
+		aParser.fail(Error::TYPE_MISMATCH);
+		return nullptr;
+	}
+	if (aParser.acceptInstruction("THEN")) {
+		if (!branch(aParser, s->thenLine, s->thenStatement)) return nullptr;
+	} else if (aParser.acceptInstruction("GOTO")) {
+		if (!aParser.lineNumber(s->thenLine)) return nullptr;
+	} else return nullptr;
+
+	if (aParser.acceptInstruction("ELSE")) {
+		if (!branch(aParser, s->elseLine, s->elseStatement)) return nullptr;
+	}
+	return s.release();
+}
+
+Error::error_t StatementIf::execute(Runtime& aRuntime) const
+{
+	Value v;
+	const auto error = condition.evaluate(aRuntime, v);
+	if (error) return error;
+	if (v.toDouble() != 0) {
+		if (thenLine.line) return aRuntime.jump(thenLine);
+		return thenStatement->execute(aRuntime);
+	}
+	if (elseLine.line) return aRuntime.jump(elseLine);
+	if (elseStatement) return elseStatement->execute(aRuntime);
+	aRuntime.pc = endOfLine;
+	return Error::OK;
+}
+
+void StatementIf::link(const Program& aProgram, const Position& aPosition)
+{
+	thenLine.resolve(aProgram);
+	elseLine.resolve(aProgram);
+	if (thenStatement) thenStatement->link(aProgram, aPosition);
+	if (elseStatement) elseStatement->link(aProgram, aPosition);
+
+	// The line may have been fused with the following ones by the optimized load.
+	const unsigned number = aPosition.number();
+	endOfLine = aPosition;
+	do endOfLine.next(aProgram);
+	while ((endOfLine.line != aProgram.cend()) && (endOfLine.number() == number));
+}
+
+void StatementIf::references(std::set<unsigned>& aLines) const
+{
+	thenLine.reference(aLines);
+	elseLine.reference(aLines);
+	if (thenStatement) thenStatement->references(aLines);
+	if (elseStatement) elseStatement->references(aLines);
+}
+
+void StatementIf::lineReferences(std::vector<LineReference*>& aLines)
+{
+	aLines.push_back(&thenLine);
+	aLines.push_back(&elseLine);
+	if (thenStatement) thenStatement->lineReferences(aLines);
+	if (elseStatement) elseStatement->lineReferences(aLines);
+}
+
+
+StatementGoto* StatementGoto::create(Parser& aParser)
+{
+	StatementGoto s;
+	if (!aParser.lineNumber(s.line)) return nullptr;
+	return new StatementGoto(s);
+}
+
+Error::error_t StatementGoto::execute(Runtime& aRuntime) const
+{
+	return aRuntime.jump(line);
+}
+
+void StatementGoto::link(const Program& aProgram, const Position&)
+{
+	line.resolve(aProgram);
+}
+
+void StatementGoto::references(std::set<unsigned>& aLines) const
+{
+	line.reference(aLines);
+}
+
+void StatementGoto::lineReferences(std::vector<LineReference*>& aLines)
+{
+	aLines.push_back(&line);
+}
+
+
+StatementGosub* StatementGosub::create(Parser& aParser)
+{
+	StatementGosub s;
+	if (!aParser.lineNumber(s.line)) return nullptr;
+	return new StatementGosub(s);
+}
+
+Error::error_t StatementGosub::execute(Runtime& aRuntime) const
+{
+	if (!line.resolved) return Error::LINE_NOT_FOUND;
+	Frame* frame = aRuntime.control.push(Frame::GOSUB);
+	if (!frame) return Error::OUT_OF_MEMORY;
+	frame->back = aRuntime.pc;
+	return aRuntime.jump(line);
+}
+
+void StatementGosub::link(const Program& aProgram, const Position&)
+{
+	line.resolve(aProgram);
+}
+
+void StatementGosub::references(std::set<unsigned>& aLines) const
+{
+	line.reference(aLines);
+}
+
+void StatementGosub::lineReferences(std::vector<LineReference*>& aLines)
+{
+	aLines.push_back(&line);
+}
+
+
+StatementReturn* StatementReturn::create(Parser& aParser)
+{
+	StatementReturn s;
+	if (!aParser.atEnd() && !aParser.lineNumber(s.line)) return nullptr;
+	return new StatementReturn(s);
+}
+
+Error::error_t StatementReturn::execute(Runtime& aRuntime) const
+{
+	// The loops opened in the subroutine end with it.
+	unsigned i;
+	if (!aRuntime.control.find(Frame::GOSUB, i)) return Error::RETURN_WITHOUT_GOSUB;
+	aRuntime.control.resize(i);
+	if (line.line) return aRuntime.jump(line);
+	aRuntime.pc = aRuntime.control[i].back;
+	return Error::OK;
+}
+
+void StatementReturn::link(const Program& aProgram, const Position&)
+{
+	line.resolve(aProgram);
+}
+
+void StatementReturn::references(std::set<unsigned>& aLines) const
+{
+	line.reference(aLines);
+}
+
+void StatementReturn::lineReferences(std::vector<LineReference*>& aLines)
+{
+	aLines.push_back(&line);
+}
+
+
+StatementOn* StatementOn::create(Parser& aParser)
+{
+	StatementOn s;
+	if (!aParser.expression(s.selector, Token::INTEGER)) return nullptr;
+	if (aParser.acceptInstruction("GOSUB")) s.gosub = true;
+	else if (aParser.acceptInstruction("GOTO")) s.gosub = false;
+	else return nullptr;
+
+	do {
+		LineReference line;
+		if (!aParser.lineNumber(line)) return nullptr;
+		s.lines.push_back(line);
+	} while (aParser.acceptSeparator(","));
+	return new StatementOn(s);
+}
+
+Error::error_t StatementOn::execute(Runtime& aRuntime) const
+{
+	int16_t n;
+	const auto error = selector.evaluate(aRuntime, n);
+	if (error) return error;
+	if ((n < 0) || (n > 255)) return Error::ILLEGAL_FUNCTION_CALL;
+	// Out of the table, the execution goes on with the next command.
+	if (!n || (static_cast<unsigned>(n) > lines.size())) return Error::OK;
+
+	const LineReference& line = lines[n - 1];
+	if (!line.resolved) return Error::LINE_NOT_FOUND;
+	if (gosub) {
+		Frame* frame = aRuntime.control.push(Frame::GOSUB);
+		if (!frame) return Error::OUT_OF_MEMORY;
+		frame->back = aRuntime.pc;
+	}
+	aRuntime.pc = line.position;
+	return Error::OK;
+}
+
+void StatementOn::link(const Program& aProgram, const Position&)
+{
+	for (auto& line : lines) line.resolve(aProgram);
+}
+
+void StatementOn::references(std::set<unsigned>& aLines) const
+{
+	for (auto&& line : lines) line.reference(aLines);
+}
+
+void StatementOn::lineReferences(std::vector<LineReference*>& aLines)
+{
+	for (auto& line : lines) aLines.push_back(&line);
+}
+
+
+StatementOnError* StatementOnError::create(Parser& aParser)
+{
+	StatementOnError s;
+	if (!aParser.acceptInstruction("GOTO") || !aParser.lineNumber(s.line)) return nullptr;
+	return new StatementOnError(s);
+}
+
+Error::error_t StatementOnError::execute(Runtime& aRuntime) const
+{
+	if (!line.line) {
+		aRuntime.errorHandler = LineReference();
+		if (!aRuntime.handlingError) return Error::OK;
+		// In the handler, the error is no longer trapped: the program stops on it, where it was raised.
+		aRuntime.current = aRuntime.errorPosition;
+		return aRuntime.lastError;
+	}
+	if (!line.resolved) return Error::LINE_NOT_FOUND;
+	aRuntime.errorHandler = line;
+	return Error::OK;
+}
+
+void StatementOnError::link(const Program& aProgram, const Position&)
+{
+	line.resolve(aProgram);
+}
+
+void StatementOnError::references(std::set<unsigned>& aLines) const
+{
+	line.reference(aLines);
+}
+
+void StatementOnError::lineReferences(std::vector<LineReference*>& aLines)
+{
+	aLines.push_back(&line);
+}
+
+
+StatementResume* StatementResume::create(Parser& aParser)
+{
+	StatementResume s;
+	s.next = aParser.acceptInstruction("NEXT");
+	if (!s.next && !aParser.atEnd() && !aParser.lineNumber(s.line)) return nullptr;
+	return new StatementResume(s);
+}
+
+Error::error_t StatementResume::execute(Runtime& aRuntime) const
+{
+	if (!aRuntime.handlingError) return Error::RESUME_WITHOUT_ERROR;
+	aRuntime.handlingError = false;
+
+	if (line.line) return aRuntime.jump(line);
+	aRuntime.pc = aRuntime.errorPosition;
+	if (next) aRuntime.pc.next(*aRuntime.program);
+	return Error::OK;
+}
+
+void StatementResume::link(const Program& aProgram, const Position&)
+{
+	line.resolve(aProgram);
+}
+
+void StatementResume::references(std::set<unsigned>& aLines) const
+{
+	line.reference(aLines);
+}
+
+void StatementResume::lineReferences(std::vector<LineReference*>& aLines)
+{
+	aLines.push_back(&line);
+}
+
+
+StatementError* StatementError::create(Parser& aParser)
+{
+	StatementError s;
+	if (!aParser.expression(s.code, Token::INTEGER)) return nullptr;
+	return new StatementError(s);
+}
+
+Error::error_t StatementError::execute(Runtime& aRuntime) const
+{
+	int16_t n;
+	const auto error = code.evaluate(aRuntime, n);
+	if (error) return error;
+	if ((n < 1) || (n > 255)) return Error::ILLEGAL_FUNCTION_CALL;
+	return static_cast<Error::error_t>(n);
+}
+
+
+StatementFor* StatementFor::create(Parser& aParser)
+{
+	StatementFor s;
+	std::string name;
+	Token::type_t type;
+	s.linked = false;
+
+	if (!aParser.identifier(name, type)) return nullptr;
+	if (type == Token::STRING) {
+		aParser.fail(Error::TYPE_MISMATCH);
+		return nullptr;
+	}
+	s.variable = aParser.getRuntime().variable(name, type);
+
+	if (!aParser.acceptOperator("=") || !aParser.expression(s.from, type)) return nullptr;
+	if (!aParser.acceptInstruction("TO") || !aParser.expression(s.to, type)) return nullptr;
+	if (aParser.acceptInstruction("STEP") && !aParser.expression(s.step, type)) return nullptr;
+	return new StatementFor(s);
+}
+
+Error::error_t StatementFor::execute(Runtime& aRuntime) const
+{
+	// A new FOR on the variable of an active loop ends that loop, and the ones it contains.
+	unsigned i;
+	if (aRuntime.control.find(Frame::FOR, i, variable)) aRuntime.control.resize(i);
+
+	Frame* frame = aRuntime.control.push(Frame::FOR);
+	if (!frame) return Error::OUT_OF_MEMORY;
+	frame->variable = variable;
+
+	Value& v = aRuntime.variables[variable];
+	Value start;
+	auto error = from.evaluate(aRuntime, start);
+	if (!error) error = to.evaluate(aRuntime, frame->limit);
+	if (!error) {
+		if (!step.empty()) error = step.evaluate(aRuntime, frame->step);
+		else {
+			frame->step = Value(static_cast<int16_t>(1));
+			error = frame->step.convert(v.type);
+		}
+	}
+	if (error) {
+		aRuntime.control.resize(aRuntime.control.size() - 1);
+		return error;
+	}
+	v.dbl = start.dbl;		// All of the same type, checked when compiling.
+
+	if (!finished(v, *frame)) {
+		frame->back = aRuntime.pc;
+		return Error::OK;
+	}
+
+	// Nothing to do: continue after the matching NEXT.
+	aRuntime.control.resize(aRuntime.control.size() - 1);
+	if (!linked) return Error::FOR_WITHOUT_NEXT;
+	aRuntime.pc = exit;
+	return Error::OK;
+}
+
+void StatementFor::link(const Program& aProgram, const Position& aPosition)
+{
+	exit = aPosition;
+	linked = skipBlock<StatementFor, StatementNext>(aProgram, exit, nextClosed);
+}
+
+
+StatementNext* StatementNext::create(Parser& aParser)
+{
+	StatementNext s;
+	if (aParser.atEnd()) return new StatementNext(s);
+
+	do {
+		std::string name;
+		Token::type_t type;
+		if (!aParser.identifier(name, type)) return nullptr;
+		s.variables.push_back(aParser.getRuntime().variable(name, type));
+	} while (aParser.acceptSeparator(","));
+	return new StatementNext(s);
+}
+
+Error::error_t StatementNext::execute(Runtime& aRuntime) const
+{
+	const unsigned count = variables.empty() ? 1 : variables.size();
+
+	for (unsigned n = 0; n < count; ++n) {
+		unsigned i;
+		if (!aRuntime.control.find(Frame::FOR, i, variables.empty() ? -1 : variables[n])) return Error::NEXT_WITHOUT_FOR;
+		aRuntime.control.resize(i + 1);
+
+		Frame& frame = aRuntime.control[i];
+		Value& v = aRuntime.variables[frame.variable];
+		bool done;
+		switch (v.type) {
+			case Token::INTEGER : {
+				const long r = long(v.integer) + frame.step.integer;
+				if ((r < -32768) || (r > 32767)) return Error::OVERFLOW_ERROR;
+				v.integer = static_cast<int16_t>(r);
+				done = frame.step.integer >= 0 ? v.integer > frame.limit.integer : v.integer < frame.limit.integer;
+				break;
+			}
+			case Token::SINGLE :
+				v.single += frame.step.single;
+				done = frame.step.single >= 0 ? v.single > frame.limit.single : v.single < frame.limit.single;
+				break;
+			default :
+				v.dbl += frame.step.dbl;
+				done = frame.step.dbl >= 0 ? v.dbl > frame.limit.dbl : v.dbl < frame.limit.dbl;
+		}
+
+		if (!done) {
+			aRuntime.pc = frame.back;
+			return Error::OK;
+		}
+		aRuntime.control.resize(i);
+	}
+	return Error::OK;
+}
+
+
+StatementWhile* StatementWhile::create(Parser& aParser)
+{
+	std::unique_ptr<StatementWhile> s(new StatementWhile());
+	s->linked = false;
+	if (!aParser.expression(s->condition)) return nullptr;
+	if (s->condition.getType() == Token::STRING) {
+		aParser.fail(Error::TYPE_MISMATCH);
+		return nullptr;
+	}
+	return s.release();
+}
+
+Error::error_t StatementWhile::execute(Runtime& aRuntime) const
+{
+	if (!linked) return Error::WHILE_WITHOUT_WEND;
+
+	// A WHILE entered again before its WEND, by a GOTO, ends its active loop and the ones it contains.
+	unsigned i;
+	if (aRuntime.control.find(aRuntime.current, i)) aRuntime.control.resize(i);
+
+	Value v;
+	const auto error = condition.evaluate(aRuntime, v);
+	if (error) return error;
+
+	if (v.toDouble() == 0) {
+		aRuntime.pc = exit;
+		return Error::OK;
+	}
+	Frame* frame = aRuntime.control.push(Frame::WHILE);
+	if (!frame) return Error::OUT_OF_MEMORY;
+	frame->back = aRuntime.current;
+	return Error::OK;
+}
+
+void StatementWhile::link(const Program& aProgram, const Position& aPosition)
+{
+	exit = aPosition;
+	linked = skipBlock<StatementWhile, StatementWend>(aProgram, exit, wendClosed);
+}
+
+
+StatementWend* StatementWend::create(Parser&)
+{
+	return new StatementWend();
+}
+
+Error::error_t StatementWend::execute(Runtime& aRuntime) const
+{
+	// Back to the WHILE, which tests its condition again.
+	unsigned i;
+	if (!aRuntime.control.find(Frame::WHILE, i)) return Error::WEND_WITHOUT_WHILE;
+	aRuntime.control.resize(i);
+	aRuntime.pc = aRuntime.control[i].back;
+	return Error::OK;
+}
+
+
+StatementDim* StatementDim::create(Parser& aParser)
+{
+	StatementDim s;
+
+	do {
+		std::string name;
+		Token::type_t type;
+		if (!aParser.identifier(name, type) || !aParser.acceptOperator("(")) return nullptr;
+
+		Declaration d;
+		d.array = aParser.getRuntime().array(name, type);
+		do {
+			Expression bound;
+			if (!aParser.expression(bound, Token::INTEGER)) return nullptr;
+			d.bounds.push_back(bound);
+		} while (aParser.acceptSeparator(","));
+		if ((d.bounds.size() > Expression::MAX_DIMENSIONS) || !aParser.acceptOperator(")")) return nullptr;
+		s.declarations.push_back(d);
+	} while (aParser.acceptSeparator(","));
+	return new StatementDim(s);
+}
+
+Error::error_t StatementDim::execute(Runtime& aRuntime) const
+{
+	for (auto&& d : declarations) {
+		std::vector<unsigned> bounds;
+		for (auto&& b : d.bounds) {
+			int16_t n;
+			const auto error = b.evaluate(aRuntime, n);
+			if (error) return error;
+			if (n < 0) return Error::ILLEGAL_FUNCTION_CALL;
+			bounds.push_back(n);
+		}
+		const auto error = aRuntime.dimension(d.array, bounds);
+		if (error) return error;
+	}
+	return Error::OK;
+}
+
+
+StatementEnd* StatementEnd::create(Parser&)
+{
+	return new StatementEnd();
+}
+
+Error::error_t StatementEnd::execute(Runtime& aRuntime) const
+{
+	aRuntime.end();
+	return Error::OK;
+}
+
+
+StatementStop* StatementStop::create(Parser&)
+{
+	return new StatementStop();
+}
+
+Error::error_t StatementStop::execute(Runtime& aRuntime) const
+{
+	if (aRuntime.column) aRuntime.newline();
+	aRuntime.print("Break in " + std::to_string(aRuntime.current.number()));
+	aRuntime.newline();
+	aRuntime.stopped = aRuntime.pc;
+	aRuntime.end();
+	return Error::OK;
+}
+
+
+StatementData* StatementData::create(Parser& aParser)
+{
+	StatementData s;
+
+	while (!aParser.done()) {
+		const bool negative = aParser.acceptOperator("-");
+		if (!negative) aParser.acceptOperator("+");
+
+		const auto pTC = aParser.done() ? nullptr : dynamic_cast<const TokenConstant*>(aParser.current());
+		Value v;
+		if (pTC && !aParser.isSeparator(",")) {
+			const auto error = Value::create(*pTC, v);
+			if (error) {
+				aParser.fail(error);
+				return nullptr;
+			}
+			aParser.next();
+			if (negative && !v.isString()) {
+				if (v.type == Token::INTEGER) v.integer = -v.integer;
+				else if (v.type == Token::SINGLE) v.single = -v.single;
+				else v.dbl = -v.dbl;
+			}
+			if (!v.isString()) v.string = (negative ? "-" : "") + pTC->getValue();
+		} else {
+			// Unquoted text: kept as a string, as written.
+			std::ostringstream text;
+			if (negative) text << '-';
+			for (bool first = true; !aParser.done() && !aParser.isSeparator(","); aParser.next(), first = false) {
+				text << (first ? "" : " ") << *aParser.current();
+			}
+			v = Value(text.str());
+		}
+		s.values.push_back(v);
+		if (!aParser.done() && !aParser.acceptSeparator(",")) return nullptr;
+	}
+	return new StatementData(s);
+}
+
+Error::error_t StatementData::execute(Runtime&) const
+{
+	return Error::OK;
+}
+
+
+StatementRead* StatementRead::create(Parser& aParser)
+{
+	StatementRead s;
+	do {
+		Lvalue target;
+		if (!aParser.lvalue(target)) return nullptr;
+		s.targets.push_back(target);
+	} while (aParser.acceptSeparator(","));
+	return new StatementRead(s);
+}
+
+Error::error_t StatementRead::execute(Runtime& aRuntime) const
+{
+	for (auto&& target : targets) {
+		if (aRuntime.dataPointer >= aRuntime.data.size()) return Error::OUT_OF_DATA;
+		const Value& datum = aRuntime.data[aRuntime.dataPointer++];
+
+		Value* v = nullptr;
+		auto error = target.resolve(aRuntime, v);
+		if (error) return error;
+
+		if (v->isString()) v->string = datum.string;
+		else if (datum.isString()) return Error::SYNTAX_ERROR;
+		else {
+			error = v->assign(datum);
+			if (error) return error;
+		}
+	}
+	return Error::OK;
+}
+
+
+StatementRestore* StatementRestore::create(Parser& aParser)
+{
+	StatementRestore s;
+	if (!aParser.atEnd() && !aParser.lineNumber(s.line)) return nullptr;
+	return new StatementRestore(s);
+}
+
+Error::error_t StatementRestore::execute(Runtime& aRuntime) const
+{
+	if (!line.line) {
+		aRuntime.dataPointer = 0;
+		return Error::OK;
+	}
+	if (aRuntime.program->find(line.line) == aRuntime.program->cend()) return Error::LINE_NOT_FOUND;
+
+	const auto it = aRuntime.dataLines.lower_bound(line.line);
+	aRuntime.dataPointer = (it == aRuntime.dataLines.cend()) ? aRuntime.data.size() : it->second;
+	return Error::OK;
+}
+
+void StatementRestore::references(std::set<unsigned>& aLines) const
+{
+	// The optimized load keeps the line as the start of a line for execute() to find it.
+	line.reference(aLines);
+}
+
+void StatementRestore::lineReferences(std::vector<LineReference*>& aLines)
+{
+	aLines.push_back(&line);
+}
+
+
+StatementRandomize* StatementRandomize::create(Parser& aParser)
+{
+	StatementRandomize s;
+	if (!aParser.acceptInstruction("TIMER") && !aParser.atEnd() && !aParser.expression(s.seed, Token::INTEGER)) return nullptr;
+	return new StatementRandomize(s);
+}
+
+Error::error_t StatementRandomize::execute(Runtime& aRuntime) const
+{
+	if (seed.empty()) {
+		aRuntime.seed = static_cast<uint32_t>(std::time(nullptr));
+		return Error::OK;
+	}
+	int16_t n;
+	const auto error = seed.evaluate(aRuntime, n);
+	if (error) return error;
+	aRuntime.seed = static_cast<uint16_t>(n) << 8;
+	return Error::OK;
+}
+
+
+StatementDeftype* StatementDeftype::create(Parser& aParser, const Token::type_t aType)
+{
+	Token::type_t* defaults = aParser.getRuntime().defaults;
+
+	do {
+		char first, last;
+		if (!letter(aParser, first)) return nullptr;
+		last = first;
+		if (aParser.acceptOperator("-") && (!letter(aParser, last) || (last < first))) return nullptr;
+		std::fill(defaults + first - 'A', defaults + last - 'A' + 1, aType);
+	} while (aParser.acceptSeparator(","));
+	return new StatementDeftype();
+}
+
+bool StatementDeftype::letter(Parser& aParser, char& aLetter)
+{
+	if (aParser.done()) return false;
+	const auto pTI = dynamic_cast<const TokenIdentifier*>(aParser.current());
+	if (!pTI || (pTI->getName().size() != 1)) return false;
+	aLetter = std::toupper(pTI->getName()[0]);
+	aParser.next();
+	return true;
+}
+
+Error::error_t StatementDeftype::execute(Runtime&) const
+{
+	return Error::OK;
+}
+
+
+StatementOpen* StatementOpen::create(Parser& aParser)
+{
+	StatementOpen s;
+	s.mode = File::RANDOM;
+
+	Expression first;
+	if (!aParser.expression(first, Token::STRING)) return nullptr;
+
+	if (aParser.acceptSeparator(",")) {
+		s.modeName = first;
+		if (!aParser.channel(s.channel) || !aParser.acceptSeparator(",") || !aParser.expression(s.name, Token::STRING)) return nullptr;
+		if (aParser.acceptSeparator(",") && !aParser.expression(s.length, Token::INTEGER)) return nullptr;
+		return new StatementOpen(s);
+	}
+
+	s.name = first;
+	if (aParser.acceptInstruction("FOR")) {
+		if (aParser.acceptInstruction("INPUT")) s.mode = File::INPUT;
+		else if (aParser.acceptInstruction("OUTPUT")) s.mode = File::OUTPUT;
+		else if (aParser.acceptWord("APPEND")) s.mode = File::APPEND;
+		else if (!aParser.acceptWord("RANDOM")) return nullptr;
+	}
+	if (!aParser.acceptWord("AS") || !aParser.channel(s.channel)) return nullptr;
+
+	// LEN is tokenized as the function.
+	const auto pTF = aParser.done() ? nullptr : dynamic_cast<const TokenFunction*>(aParser.current());
+	if (pTF && (pTF->getString() == "LEN")) {
+		aParser.next();
+		if (!aParser.acceptOperator("=") || !aParser.expression(s.length, Token::INTEGER)) return nullptr;
+	}
+	return new StatementOpen(s);
+}
+
+Error::error_t StatementOpen::execute(Runtime& aRuntime) const
+{
+	File::mode_t m = mode;
+	Value v;
+	Error::error_t error;
+	if (!modeName.empty()) {
+		error = modeName.evaluate(aRuntime, v);
+		if (error) return error;
+		static const char modes[] = "IOAR";		// Indexed by File::mode_t.
+		const char* p = v.string.empty() ? nullptr : std::strchr(modes, std::toupper(v.string[0]));
+		if (!p || !*p) return Error::BAD_FILE_MODE;
+		m = static_cast<File::mode_t>(p - modes);
+	}
+
+	int16_t n, l = 128;
+	error = channel.evaluate(aRuntime, n);
+	if (!error && !length.empty()) error = length.evaluate(aRuntime, l);
+	if (!error) error = name.evaluate(aRuntime, v);
+	if (error) return error;
+	return aRuntime.files.open(n, v.string, m, l);
+}
+
+
+StatementClose* StatementClose::create(Parser& aParser)
+{
+	StatementClose s;
+	if (!aParser.atEnd()) {
+		do {
+			Expression channel;
+			if (!aParser.channel(channel)) return nullptr;
+			s.channels.push_back(channel);
+		} while (aParser.acceptSeparator(","));
+	}
+	return new StatementClose(s);
+}
+
+Error::error_t StatementClose::execute(Runtime& aRuntime) const
+{
+	if (channels.empty()) return aRuntime.files.closeAll();
+
+	for (auto&& channel : channels) {
+		int16_t n;
+		auto error = channel.evaluate(aRuntime, n);
+		if (!error) error = aRuntime.files.close(n);
+		if (error) return error;
+	}
+	return Error::OK;
+}
+
+
+StatementField* StatementField::create(Parser& aParser)
+{
+	StatementField s;
+	if (!aParser.channel(s.channel)) return nullptr;
+
+	while (aParser.acceptSeparator(",")) {
+		Item item;
+		std::string name;
+		Token::type_t type;
+		if (!aParser.expression(item.width, Token::INTEGER) || !aParser.acceptWord("AS") || !aParser.identifier(name, type)) return nullptr;
+		if (type != Token::STRING) {
+			aParser.fail(Error::TYPE_MISMATCH);
+			return nullptr;
+		}
+		item.variable = aParser.getRuntime().variable(name, type);
+		s.items.push_back(item);
+	}
+	return new StatementField(s);
+}
+
+Error::error_t StatementField::execute(Runtime& aRuntime) const
+{
+	File* f;
+	auto error = channelFile(aRuntime, channel, 1 << File::RANDOM, f);
+	if (error) return error;
+
+	unsigned offset = 0;
+	for (auto&& item : items) {
+		int16_t w;
+		error = item.width.evaluate(aRuntime, w);
+		if (error) return error;
+		if ((w < 0) || (w > 255)) return Error::ILLEGAL_FUNCTION_CALL;
+		if (offset + w > f->length) return Error::FIELD_OVERFLOW;
+
+		const unsigned variable = item.variable;
+		const auto it = std::find_if(f->fields.begin(), f->fields.end(), [variable](const File::Field& aField) {
+			return aField.variable == variable;
+		});
+		if (it == f->fields.end()) {
+			f->fields.push_back(File::Field{ offset, static_cast<unsigned>(w), variable });
+		} else {
+			it->offset = offset;
+			it->width = w;
+		}
+		aRuntime.variables[variable].string.assign(w, ' ');
+		offset += w;
+	}
+	return Error::OK;
+}
+
+
+StatementGet* StatementGet::create(Parser& aParser, const bool aPut)
+{
+	StatementGet s;
+	s.put = aPut;
+	if (!aParser.channel(s.channel)) return nullptr;
+	if (aParser.acceptSeparator(",") && !aParser.expression(s.record, Token::DOUBLE)) return nullptr;
+	return new StatementGet(s);
+}
+
+Error::error_t StatementGet::execute(Runtime& aRuntime) const
+{
+	File* f;
+	auto error = channelFile(aRuntime, channel, 1 << File::RANDOM, f);
+	if (error) return error;
+
+	unsigned long r = f->record + 1;
+	if (!record.empty()) {
+		Value v;
+		error = record.evaluate(aRuntime, v);
+		if (error) return error;
+		const double d = std::floor(v.dbl + 0.5);
+		if ((d < 1) || (d > 16777215)) return Error::BAD_RECORD_NUMBER;
+		r = static_cast<unsigned long>(d);
+	}
+	return put ? aRuntime.files.write(*f, r, aRuntime.variables) : aRuntime.files.read(*f, r, aRuntime.variables);
+}
+
+
+StatementLset* StatementLset::create(Parser& aParser, const bool aRight)
+{
+	StatementLset s;
+	s.right = aRight;
+	if (!aParser.lvalue(s.target)) return nullptr;
+	if (s.target.type != Token::STRING) {
+		aParser.fail(Error::TYPE_MISMATCH);
+		return nullptr;
+	}
+	if (!aParser.acceptOperator("=") || !aParser.expression(s.value, Token::STRING)) return nullptr;
+	return new StatementLset(s);
+}
+
+Error::error_t StatementLset::execute(Runtime& aRuntime) const
+{
+	Value v;
+	Value* t;
+	auto error = value.evaluate(aRuntime, v);
+	if (!error) error = target.resolve(aRuntime, t);
+	if (error) return error;
+
+	// The variable keeps its length, and its storage: a FIELD variable stays the size of its field.
+	std::string& s = t->string;
+	const std::size_t n = std::min(s.size(), v.string.size());
+	if (right) {
+		std::fill(s.begin(), s.end() - n, ' ');
+		std::copy_n(v.string.begin(), n, s.end() - n);
+	} else {
+		std::copy_n(v.string.begin(), n, s.begin());
+		std::fill(s.begin() + n, s.end(), ' ');
+	}
+	return Error::OK;
+}
+
+
+StatementChain* StatementChain::create(Parser& aParser)
+{
+	StatementChain s;
+	s.line = 0;
+	s.all = false;
+	if (!aParser.expression(s.file, Token::STRING)) return nullptr;
+	if (aParser.acceptSeparator(",")) {
+		aParser.lineNumber(s.line);
+		if (aParser.acceptSeparator(",") && !(s.all = aParser.acceptWord("ALL"))) return nullptr;
+	}
+	return new StatementChain(s);
+}
+
+Error::error_t StatementChain::execute(Runtime& aRuntime) const
+{
+	Value v;
+	const auto error = file.evaluate(aRuntime, v);
+	if (error) return error;
+
+	aRuntime.chain.file = v.string;
+	aRuntime.chain.line = line;
+	aRuntime.chain.all = all;
+	aRuntime.end();
+	return Error::OK;
+}
+
+
+StatementCommon* StatementCommon::create(Parser& aParser)
+{
+	StatementCommon s;
+	do {
+		std::string name;
+		Token::type_t type;
+		if (!aParser.identifier(name, type)) return nullptr;
+		if (aParser.acceptOperator("(")) {
+			if (!aParser.acceptOperator(")")) return nullptr;
+			s.arrays.insert(aParser.getRuntime().array(name, type));
+		} else {
+			s.variables.insert(aParser.getRuntime().variable(name, type));
+		}
+	} while (aParser.acceptSeparator(","));
+	return new StatementCommon(s);
+}
+
+Error::error_t StatementCommon::execute(Runtime&) const
+{
+	return Error::OK;
+}
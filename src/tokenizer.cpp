@@ -57,18 +57,19 @@ std::vector<Token*> Tokenizer::tokenize(const std::string& aLine, bool& err, int
 			continue;
 		}
 
-		auto pTId = TokenIdentifier::create(posit, end);
-		if (pTId) {
-			list.push_back(pTId);
-			continue;
-		}
-
+		// Before identifiers, for the word operators (AND, OR...).
 		auto pTOp = TokenOperator::create(posit, end);
 		if (pTOp) {
 			list.push_back(pTOp);
 			continue;
 		}
 
+		auto pTId = TokenIdentifier::create(posit, end);
+		if (pTId) {
+			list.push_back(pTId);
+			continue;
+		}
+
 		auto pTCo = TokenConstant::create(posit, end);
 		if (pTCo) {
 			list.push_back(pTCo);
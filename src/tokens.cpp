@@ -16,8 +16,26 @@
 
 #include "tokens.h"
 
+#include <cctype>
 #include <iostream>
 
+namespace {
+
+/**
+ * True if the text starts with a keyword, whatever its case.
+ * Comparing in place is much cheaper than building a regex for each keyword tried.
+ **/
+bool startsWith(const std::string::const_iterator& aStart, const std::string::const_iterator& aStop, const std::string& aKeyword)
+{
+	if (static_cast<std::size_t>(aStop - aStart) < aKeyword.size()) return false;
+	for (std::size_t i = 0; i < aKeyword.size(); ++i) {
+		if (std::toupper(static_cast<unsigned char>(aStart[i])) != aKeyword[i]) return false;
+	}
+	return true;
+}
+
+}
+
 TokenComment::TokenComment(const std::string& aText) : text(aText) {}
 
 TokenComment* TokenComment::create(std::string::const_iterator& aStart, const std::string::const_iterator& aStop)
@@ -32,9 +50,9 @@ TokenComment* TokenComment::create(std::string::const_iterator& aStart, const st
 	return nullptr; // No instruction found!
 }
 
-std::string TokenComment::toString() const
+void TokenComment::print(std::ostream& out) const
 {
-	return "REM" + text;
+	out << "REM" << text;
 }
 
 
@@ -43,8 +61,7 @@ TokenInstruction::TokenInstruction(const unsigned aId) : id(aId) {}
 TokenInstruction* TokenInstruction::create(std::string::const_iterator& aStart, const std::string::const_iterator& aStop)
 {
 	for (unsigned i = 0; i < sizeof(tokens) / sizeof(tokens[0]) ; ++i) {
-		const std::regex exp("^" + tokens[i] + ".*", std::regex_constants::icase);
-		if (std::regex_match(aStart, aStop, exp)) {
+		if (startsWith(aStart, aStop, tokens[i])) {
 			aStart += tokens[i].size();
 			return new TokenInstruction(i);
 		}
@@ -57,16 +74,16 @@ const std::string& TokenInstruction::getString() const
 	return tokens[id];
 }
 
-std::string TokenInstruction::toString() const
+void TokenInstruction::print(std::ostream& out) const
 {
-	return getString();
+	out << getString();
 }
 
 const std::string TokenInstruction::tokens[] = {
 	"AUTO",
 	"BEEP", "BLOAD", "BSAVE",
-	"CALL", "CHAIN", "CHDIR", "CIRCLE", "CLEAR", "CLOSE", "CLS", "COLOR", "COM", "COMMON", "CONT",
-	"DATA", "DEF", "FNSEG", "FNUSR", "DELETE", "DIM", "DRAW",
+	"CALL", "CHAIN", "CHDIR", "CIRCLE", "CLEAR", "CLOSE", "CLS", "COLOR", "COMMON", "COM", "CONT",
+	"DATA", "DEFDBL", "DEFINT", "DEFSNG", "DEFSTR", "DEF", "FNSEG", "FNUSR", "DELETE", "DIM", "DRAW",
 	"EDIT", "ELSE", "END", "ERASE", "ERROR",
 	"FIELD", "FILES", "FOR", "TO", "STEP",
 	"GET", "GOSUB", "GOTO",
@@ -75,7 +92,7 @@ const std::string TokenInstruction::tokens[] = {
 	"LET", "LINE", "LIST", "LLIST", "LOAD", "LOCK", "LPRINT", "LSET",
 	"MERGE", "MKDIR",
 	"NAME", "NEXT", "NEW",
-	"ON", "COM", "PLAY", "STRIG", "TIMER", "OPEN", "OPTION_BASE", "OUT",
+	"ON", "COM", "PLAY", "STRIG", "TIMER", "OPEN", "OPTION_BASE", "OUTPUT", "OUT",
 	"PAINT", "PALETTE", "PEEK", "PEN", "PLAY", "PMAP", "POINT", "POKE", "PRESET", "PRINT", "PSET", "PUT",
 	"RANDOMIZE", "READ", "RENUM", "RESET", "RESTORE", "RESUME", "RETURN", "RMDIR", "RSET", "RUN",
 	"SAVE", "SCREEN", "SHELL", "SOUND", "STOP", "STRIG", "SYSTEM",
@@ -89,8 +106,7 @@ TokenFunction::TokenFunction(const unsigned aId) : id(aId) {}
 TokenFunction* TokenFunction::create(std::string::const_iterator& aStart, const std::string::const_iterator& aStop)
 {
 	for (unsigned i = 0; i < sizeof(tokens) / sizeof(tokens[0]) ; ++i) {
-		const std::regex exp("^" + tokens[i] + ".*", std::regex_constants::icase);
-		if (std::regex_match(aStart, aStop, exp)) {
+		if (startsWith(aStart, aStop, tokens[i])) {
 			aStart += tokens[i].size();
 			return new TokenFunction(i);
 		}
@@ -98,12 +114,31 @@ TokenFunction* TokenFunction::create(std::string::const_iterator& aStart, const
 	return nullptr; // No instruction found!
 }
 
-std::string TokenFunction::toString() const
+const std::string& TokenFunction::getString() const
 {
 	return tokens[id];
 }
 
+void TokenFunction::print(std::ostream& out) const
+{
+	out << getString();
+}
+
 const std::string TokenFunction::tokens[] = {
+	"ABS", "ASC", "ATN",
+	"CDBL", "CHR$", "CINT", "COS", "CSNG", "CVD", "CVI", "CVS",
+	"EOF", "ERL", "ERR", "EXP",
+	"FIX",
+	"HEX$",
+	"INSTR", "INT",
+	"LEFT$", "LEN", "LOC", "LOF", "LOG",
+	"MID$", "MKD$", "MKI$", "MKS$",
+	"OCT$",
+	"POS",
+	"RIGHT$", "RND",
+	"SGN", "SIN", "SPACE$", "SPC", "SQR", "STR$", "STRING$",
+	"TAB", "TAN",
+	"VAL"
 };
 
 
@@ -111,12 +146,13 @@ TokenIdentifier::TokenIdentifier(const std::string& aName, const type_t& aType)
 
 TokenIdentifier* TokenIdentifier::create(std::string::const_iterator& aStart, const std::string::const_iterator& aStop)
 {
-	static const std::regex exp("^([A-Z]+\\w*[\\$%]?).*", std::regex_constants::icase);
+	static const std::regex exp("^([A-Z]+\\w*[\\$%!#]?).*", std::regex_constants::icase);
 
 	std::smatch sm;
 	if (std::regex_match(aStart, aStop, sm, exp)) {
 		aStart += sm[1].length();
-		const type_t t = sm[1].str()[sm[1].length() - 1] == '$' ? STRING : (sm[1].str()[sm[1].length() - 1] == '%' ? INTEGER : SINGLE);
+		const char suffix = sm[1].str()[sm[1].length() - 1];
+		const type_t t = suffix == '$' ? STRING : (suffix == '%' ? INTEGER : (suffix == '#' ? DOUBLE : SINGLE));
 		return new TokenIdentifier(sm[1], t);
 	}
 	return nullptr; // No identifier found!
@@ -132,75 +168,97 @@ const Token::type_t& TokenIdentifier::getType() const
 	return type;
 }
 
-std::string TokenIdentifier::toString() const
+bool TokenIdentifier::hasSuffix() const
 {
-	return name;
+	return std::string("$%!#").find(name.back()) != std::string::npos;
 }
 
+void TokenIdentifier::print(std::ostream& out) const
+{
+	out << name;
+}
 
-TokenOperator::TokenOperator(const std::string& aId) : id(aId) {}
+
+TokenOperator::TokenOperator(const std::string& aId) :
+	id(aId),
+	spacing(aId == "(" ? OPEN : aId == ")" ? CLOSE : (aId == "-") || (aId == "+") ? SIGN : OPERATOR)
+{
+}
 
 TokenOperator* TokenOperator::create(std::string::const_iterator& aStart, const std::string::const_iterator& aStop)
 {
-	static const std::regex exp("^([+\\-*\\/<>=()\\[\\]\\%\\^]+).*", std::regex_constants::icase);
+	static const std::regex exp("^(<>|><|<=|=<|>=|=>|[+\\-*\\/\\\\<>=()\\^]).*");
+	static const std::regex expWord("^(AND|OR|XOR|NOT|MOD|EQV|IMP).*", std::regex_constants::icase);
 
 	std::smatch sm;
 	if (std::regex_match(aStart, aStop, sm, exp)) {
 		aStart += sm[1].length();
 		return new TokenOperator(sm[1]);
 	}
+	if (std::regex_match(aStart, aStop, sm, expWord)) {
+		aStart += sm[1].length();
+		std::string word(sm[1]);
+		for (auto& c : word) c = std::toupper(c);
+		return new TokenOperator(word);
+	}
 	return nullptr; // No identifier found!
 }
 
-std::string TokenOperator::toString() const
+const std::string& TokenOperator::getId() const
 {
 	return id;
 }
 
+void TokenOperator::print(std::ostream& out) const
+{
+	out << id;
+}
+
 
 TokenConstant::TokenConstant(const std::string& aValue, const type_t& aType) : value(aValue), type(aType) {}
 
 TokenConstant* TokenConstant::create(std::string::const_iterator& aStart, const std::string::const_iterator& aStop)
 {
-	static const std::regex expString("^\"(.*?[^\\\\])\".*");
+	static const std::regex expString("^(\"([^\"]*)\"?).*");
 	static const std::regex expChanel("^(#\\d+).*");
 
-	static const std::regex expSingle("^(\\d*[.]\\d+(E[+-]?\\d+)?!?|\\d+E[+-]?\\d+!?|\\d+!).*", std::regex_constants::icase);
-	static const std::regex expDouble("^(\\d*[.]\\d+(D[+-]?\\d+)?#?|\\d+D[+-]?\\d+#?|\\d+#).*", std::regex_constants::icase);
+	static const std::regex expDouble("^((\\d+[.]?\\d*|[.]\\d+)(D[+-]?\\d+#?|#)).*", std::regex_constants::icase);
+	static const std::regex expSingle("^((\\d+[.]\\d*|[.]\\d+)(E[+-]?\\d+)?!?|\\d+(E[+-]?\\d+!?|!)).*", std::regex_constants::icase);
 	static const std::regex expInt("^(\\d+).*");
-	static const std::regex expHexa("^&H([\\dA-F]+).*");
-	static const std::regex expOctal("^&O?([1-8]+).*");
+	static const std::regex expHexa("^(&H([\\dA-F]+)).*", std::regex_constants::icase);
+	static const std::regex expOctal("^(&O?([0-7]+)).*", std::regex_constants::icase);
 
 	std::smatch sm;
 
+	// An unterminated string ends with the line, as in GW-BASIC.
 	if (std::regex_match(aStart, aStop, sm, expString)) {
-		aStart += sm[1].length() + 2; // 2 quotes char.
-		return new TokenConstant(sm[1], STRING);
+		aStart += sm[1].length();
+		return new TokenConstant(sm[2], STRING);
 	}
 	if (std::regex_match(aStart, aStop, sm, expChanel)) {
 		aStart += sm[1].length();
 		return new TokenConstant(sm[1], CHANEL);
 	}
 
-	if (std::regex_match(aStart, aStop, sm, expSingle)) {
-		aStart += sm[1].length();
-		return new TokenConstant(sm[1], SINGLE);
-	}
 	if (std::regex_match(aStart, aStop, sm, expDouble)) {
 		aStart += sm[1].length();
 		return new TokenConstant(sm[1], DOUBLE);
 	}
+	if (std::regex_match(aStart, aStop, sm, expSingle)) {
+		aStart += sm[1].length();
+		return new TokenConstant(sm[1], SINGLE);
+	}
 	if (std::regex_match(aStart, aStop, sm, expInt)) {
 		aStart += sm[1].length();
 		return new TokenConstant(sm[1], INTEGER);
 	}
 	if (std::regex_match(aStart, aStop, sm, expHexa)) {
 		aStart += sm[1].length();
-		return new TokenConstant(sm[1], HEXADECIMAL);
+		return new TokenConstant(sm[2], HEXADECIMAL);
 	}
 	if (std::regex_match(aStart, aStop, sm, expOctal)) {
 		aStart += sm[1].length();
-		return new TokenConstant(sm[1], OCTAL);
+		return new TokenConstant(sm[2], OCTAL);
 	}
 	return nullptr; // No identifier found!
 }
@@ -215,9 +273,14 @@ const std::string& TokenConstant::getValue() const
 	return value;
 }
 
-std::string TokenConstant::toString() const
+void TokenConstant::print(std::ostream& out) const
 {
-	return (type == STRING ? '"' + value + '"' : value);
+	switch (type) {
+		case STRING : out << '"' << value << '"'; break;
+		case HEXADECIMAL : out << "&H" << value; break;
+		case OCTAL : out << "&O" << value; break;
+		default : out << value;
+	}
 }
 
 
@@ -240,20 +303,36 @@ const std::string& TokenSeparator::getId() const
 	return id;
 }
 
-std::string TokenSeparator::toString() const
+void TokenSeparator::print(std::ostream& out) const
 {
-	return id;
+	out << id;
 }
 
 std::ostream& operator<<(std::ostream& out, const Token& t)
 {
-	return out << t.toString();
+	t.print(out);
+	return out;
 }
 
-std::ostream& operator<<(std::ostream& out, const std::vector<Token*> list)
+std::ostream& operator<<(std::ostream& out, const std::vector<Token*>& list)
 {
-	for (auto&& token : list)
-//		out << (token == *list.begin() ? "" : " ") << *token;
-		out << *token;
+	Token::spacing_t previous = Token::SEPARATOR;
+	for (auto itToken = list.cbegin(); itToken != list.cend(); ++itToken) {
+		Token::spacing_t current = (*itToken)->getSpacing();
+		// + and - are signs at the start of an expression, binary operators after an operand.
+		if ((current == Token::SIGN) && ((previous == Token::WORD) || (previous == Token::FUNCTION) || (previous == Token::CLOSE))) current = Token::OPERATOR;
+		if (itToken != list.cbegin()) {
+			bool space;
+			switch (current) {
+				case Token::SEPARATOR :
+				case Token::CLOSE : space = false; break;
+				case Token::OPEN : space = (previous == Token::KEYWORD) || (previous == Token::OPERATOR) || (previous == Token::SEPARATOR); break;
+				default : space = (previous != Token::OPEN) && (previous != Token::SIGN);
+			}
+			if (space) out << ' ';
+		}
+		out << **itToken;
+		previous = current;
+	}
 	return out;
 }
@@ -0,0 +1,182 @@
+/**
+ * Copyright [2024] Marc SIBERT
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include "value.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+/**
+ * Format a number with the given significant digits, GW-BASIC way: "0.5" is written ".5".
+ **/
+static std::string format(const double aValue, const int aDigits)
+{
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%.*G", aDigits, aValue);
+
+	std::string s(buffer);
+	if (s.compare(0, 2, "0.") == 0) s.erase(0, 1);
+	else if (s.compare(0, 3, "-0.") == 0) s.erase(1, 1);
+	return s[0] == '-' ? s : ' ' + s;
+}
+
+Error::error_t Value::create(const TokenConstant& aToken, Value& aValue)
+{
+	const std::string& text = aToken.getValue();
+
+	switch (aToken.getType()) {
+		case Token::STRING :
+			aValue = Value(text);
+			return Error::OK;
+		case Token::INTEGER : {
+			const double d = std::strtod(text.c_str(), nullptr);
+			if (d <= 32767) aValue = Value(static_cast<int16_t>(d));
+			else if (text.size() <= 7) aValue = Value(static_cast<float>(d));
+			else aValue = Value(d);
+			return Error::OK;
+		}
+		case Token::SINGLE :
+			aValue = Value(static_cast<float>(std::strtod(text.c_str(), nullptr)));
+			return std::isinf(aValue.single) ? Error::OVERFLOW_ERROR : Error::OK;
+		case Token::DOUBLE : {
+			std::string s(text);
+			for (auto& c : s) if (c == 'D' || c == 'd') c = 'E';
+			aValue = Value(std::strtod(s.c_str(), nullptr));
+			return std::isinf(aValue.dbl) ? Error::OVERFLOW_ERROR : Error::OK;
+		}
+		case Token::HEXADECIMAL :
+		case Token::OCTAL : {
+			const unsigned long l = std::strtoul(text.c_str(), nullptr, aToken.getType() == Token::OCTAL ? 8 : 16);
+			if (l > 0xFFFF) return Error::OVERFLOW_ERROR;
+			aValue = Value(static_cast<int16_t>(static_cast<uint16_t>(l)));
+			return Error::OK;
+		}
+		default :
+			return Error::SYNTAX_ERROR;
+	}
+}
+
+Value Value::parse(const std::string& aText)
+{
+	auto it = aText.cbegin();
+	while (it != aText.cend() && (*it == ' ' || *it == '\t')) ++it;
+
+	if ((it != aText.cend()) && (*it == '&')) {
+		const bool octal = (it + 1 == aText.cend()) || (std::toupper(it[1]) != 'H');
+		const std::string digits(it + ((it + 1 != aText.cend() && std::isalpha(it[1])) ? 2 : 1), aText.cend());
+		return Value(static_cast<int16_t>(static_cast<uint16_t>(std::strtoul(digits.c_str(), nullptr, octal ? 8 : 16))));
+	}
+
+	std::string s;
+	unsigned digits = 0;
+	bool dbl = false;
+	for (; it != aText.cend(); ++it) {
+		const char c = std::toupper(*it);
+		if (std::isdigit(c)) {
+			if (s.find('E') == std::string::npos) ++digits;
+			s += c;
+		} else if (c == 'D') {
+			dbl = true;
+			s += 'E';
+		} else if (c == '#') {
+			dbl = true;
+			break;
+		} else if (c == '+' || c == '-' || c == '.' || c == 'E') s += c;
+		else if (c != ' ') break;
+	}
+
+	const double d = std::strtod(s.c_str(), nullptr);
+	if (dbl || digits > 7) return Value(d);
+	return Value(static_cast<float>(d));
+}
+
+Value Value::zero(const Token::type_t aType)
+{
+	switch (aType) {
+		case Token::STRING : return Value(std::string());
+		case Token::INTEGER : return Value(static_cast<int16_t>(0));
+		case Token::DOUBLE : return Value(0.0);
+		default : return Value(0.0f);
+	}
+}
+
+Error::error_t Value::toInteger(int16_t& aInteger) const
+{
+	if (type == Token::INTEGER) {
+		aInteger = integer;
+		return Error::OK;
+	}
+	if (type == Token::STRING) return Error::TYPE_MISMATCH;
+
+	const double d = std::floor(toDouble() + 0.5);
+	if ((d < -32768) || (d > 32767)) return Error::OVERFLOW_ERROR;
+	aInteger = static_cast<int16_t>(d);
+	return Error::OK;
+}
+
+Error::error_t Value::convert(const Token::type_t aType)
+{
+	if (type == aType) return Error::OK;
+	if ((type == Token::STRING) || (aType == Token::STRING)) return Error::TYPE_MISMATCH;
+
+	switch (aType) {
+		case Token::INTEGER : {
+			int16_t i;
+			const auto error = toInteger(i);
+			if (error) return error;
+			integer = i;
+			break;
+		}
+		case Token::SINGLE : {
+			const float f = static_cast<float>(toDouble());
+			if (std::isinf(f)) return Error::OVERFLOW_ERROR;
+			single = f;
+			break;
+		}
+		default :
+			dbl = toDouble();
+	}
+	type = aType;
+	return Error::OK;
+}
+
+Error::error_t Value::assign(const Value& aValue)
+{
+	if (type == aValue.type) {
+		if (type == Token::STRING) string = aValue.string;
+		else dbl = aValue.dbl;		// copies the whole union.
+		return Error::OK;
+	}
+	if ((type == Token::STRING) || aValue.isString()) return Error::TYPE_MISMATCH;
+
+	Value v(aValue);
+	const auto error = v.convert(type);
+	if (error) return error;
+	dbl = v.dbl;
+	return Error::OK;
+}
+
+std::string Value::toString() const
+{
+	switch (type) {
+		case Token::STRING : return string;
+		case Token::INTEGER : return (integer < 0 ? "" : " ") + std::to_string(integer);
+		case Token::SINGLE : return format(single, 7);
+		default : return format(dbl, 16);
+	}
+}
@@ -0,0 +1,8 @@
+10 DIM A(5)
+20 FOR I = 1 TO 5 : A(I) = I * I : NEXT I
+30 N = 42 : S$ = "hello" : X = 3.5
+40 COMMON N, S$, A(), C
+50 PRINT "chain.bas"; C; N; X
+60 C = C + 1
+70 IF C > 2 THEN PRINT "done" : END
+80 CHAIN "chain.chained"
@@ -0,0 +1,7 @@
+10 REM The constants are converted when loading, never while running
+20 FOR I = 1 TO 100 : X = X + 1 : Y# = Y# + 2 : NEXT I
+30 PRINT X; Y#; 1.5 + 1; 2 * 0.25; 7 MOD 2.2
+40 I% = 2 : PRINT I% + 0.5; 10 \ I%
+50 ON ERROR GOTO 70
+60 PRINT 1 AND 40000
+70 PRINT "error"; ERR; "in"; ERL
@@ -0,0 +1,13 @@
+5 PRINT "deleted 5"
+10 ON ERROR GOTO 100
+20 PRINT "kept 20"
+30 PRINT "deleted 30"
+40 PRINT "kept 40"
+50 PRINT "deleted 50"
+60 PRINT "deleted 60"
+70 GOTO 50
+80 PRINT "kept 80"
+90 GOTO 60
+95 PRINT "end" : END
+100 PRINT "error"; ERR; "in"; ERL
+110 RESUME NEXT
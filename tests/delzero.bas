@@ -0,0 +1 @@
+10 PRINT "never run"
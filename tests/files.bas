@@ -0,0 +1,37 @@
+10 REM Sequential files
+20 OPEN "seq.txt" FOR OUTPUT AS #1
+30 PRINT #1, "one"; 2; 3.5
+40 PRINT #1, "two,three"
+50 PRINT #1, "last line"
+60 CLOSE #1
+70 OPEN "I", #1, "seq.txt"
+80 LINE INPUT #1, L$ : PRINT L$
+90 INPUT #1, A$, B$ : PRINT A$; "|"; B$
+100 WHILE NOT EOF(1) : LINE INPUT #1, L$ : PRINT L$ : WEND
+110 CLOSE
+120 OPEN "seq.txt" FOR APPEND AS #2 : PRINT #2, "appended" : CLOSE #2
+130 OPEN "seq.txt" FOR INPUT AS #2
+140 WHILE NOT EOF(2) : LINE INPUT #2, L$ : N = N + 1 : WEND : CLOSE #2
+150 PRINT N; L$
+200 REM Random files, larger than the cache so that its blocks are evicted and written back
+210 OPEN "rnd.dat" AS #1 LEN = 512
+220 FIELD #1, 4 AS K$, 10 AS T$, 250 AS P$, 248 AS Q$
+230 FOR R = 1 TO 1000
+240 LSET K$ = MKS$(R * 1.5) : RSET T$ = STR$(R) : LSET P$ = "record" + STR$(R) : LSET Q$ = "end"
+250 PUT #1, R
+260 NEXT R
+270 PRINT LOF(1); LOC(1)
+280 GET #1, 3 : PRINT CVS(K$); "["; T$; "]"; LEFT$(P$, 10)
+290 CLOSE #1
+300 REM Reopened after CLOSE, the records written are read back from the file
+310 OPEN "R", #3, "rnd.dat", 512
+320 FIELD #3, 4 AS K$, 10 AS T$, 250 AS P$, 248 AS Q$
+330 FOR R = 1 TO 1000
+340 GET #3, R
+350 IF CVS(K$) <> R * 1.5 OR VAL(T$) <> R OR LEFT$(P$, 6 + LEN(STR$(R))) <> "record" + STR$(R) OR LEFT$(Q$, 3) <> "end" THEN PRINT "bad record"; R : END
+360 NEXT R
+370 GET #3, 1000 : PRINT CVS(K$); "["; T$; "]"; LEFT$(P$, 12); LOC(3)
+380 GET #3, 1 : PRINT CVS(K$); "["; T$; "]"; LEFT$(P$, 8)
+390 CLOSE #3
+400 REM LINE INPUT from the console keeps the commas and the quotes
+410 LINE INPUT "Line: "; S$ : PRINT "["; S$; "]"
@@ -0,0 +1,14 @@
+10 ON ERROR GOTO 200
+20 I = 0
+30 WHILE I > 0
+40 PRINT "NEVER"
+50 WEND
+60 PRINT "SKIPPED"
+70 GOSUB 100
+80 PRINT "BACK"
+90 END
+100 PRINT "SUB"
+110 X = 1 +
+120 RETURN
+200 PRINT "ERROR"; ERR; "IN"; ERL
+210 RESUME 120
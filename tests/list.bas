@@ -0,0 +1,6 @@
+10 REM Listing
+20 FOR I=1 TO 3:PRINT I;"x";:NEXT I
+30   IF A$="" THEN 50 ELSE PRINT "no"
+40 GOSUB 60: REM comment
+50 DATA 1,"two" , 3
+60 X = (A+B)*2 : RETURN
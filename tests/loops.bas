@@ -0,0 +1,20 @@
+10 ON ERROR GOTO 900
+20 REM A FOR entered again by GOTO, without its NEXT, takes the frame of its variable back
+30 FOR I = 1 TO 10
+40 N = N + 1 : IF N < 1000 THEN 30
+50 NEXT I : PRINT "for"; N; I
+60 REM NEXT J drops the frame of K, left by GOTO
+70 FOR J = 1 TO 1000 : FOR K = 1 TO 10 : IF K = 3 THEN 90
+80 NEXT K
+90 NEXT J : PRINT "nested"; J; K
+100 REM A WHILE entered again by GOTO, before its WEND, takes its frame back
+110 N = 0
+120 WHILE N < 1000
+130 N = N + 1 : IF N MOD 2 THEN 120
+140 WEND : PRINT "while"; N
+150 REM RETURN drops the frames of the loops left inside the subroutine
+160 FOR R = 1 TO 1000 : GOSUB 500 : NEXT R : PRINT "gosub"; R; S
+170 END
+500 FOR L = 1 TO 5 : WHILE L < 9 : S = S + 1 : IF S MOD 3 THEN RETURN
+510 WEND : NEXT L : RETURN
+900 PRINT "error"; ERR; "in"; ERL : END
@@ -0,0 +1,9 @@
+5 DEFINT A-Z
+10 PRINT "kept 10"
+20 PRINT "replaced 20"
+30 GOSUB 100
+40 PRINT "replaced 40" : GOTO 60
+50 PRINT "kept 50"
+60 END
+100 PRINT "replaced 100"
+110 RETURN
@@ -0,0 +1,3 @@
+10 PRINT "before"
+20 A$ = 1
+30 PRINT "after"
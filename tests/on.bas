@@ -0,0 +1,29 @@
+10 ON ERROR GOTO 500
+20 FOR I = 0 TO 4
+30 ON I GOTO 40, 50, 60
+35 PRINT "none"; I : GOTO 70
+40 PRINT "goto 1" : GOTO 70
+50 PRINT "goto 2" : GOTO 70
+60 PRINT "goto 3"
+70 NEXT I
+80 FOR I = 0 TO 3 : ON I GOSUB 300, 310 : PRINT "after"; I : NEXT I
+90 ON 2.6 GOSUB 300, 310, 320 : PRINT
+100 K = -1 : ON K GOTO 40
+110 K = 256 : ON K GOSUB 300
+120 K = 255 : ON K GOTO 40 : PRINT "255 falls through"
+130 REM RESUME retries the statement once the cause of the error is gone
+140 D = 0 : PRINT 10 / D
+150 PRINT "resumed"
+160 ERROR 200 : PRINT "next"
+170 ERROR 201 : PRINT "skipped"
+180 PRINT "resumed at 180" : ON ERROR GOTO 0 : ON ERROR GOTO 600
+190 ERROR 5
+200 END
+300 PRINT "gosub 1"; : RETURN
+310 PRINT "gosub 2"; : RETURN
+320 PRINT "gosub 3"; : RETURN
+500 PRINT "error"; ERR; "in"; ERL
+510 IF ERR = 11 THEN D = 2 : RESUME
+520 IF ERR = 201 THEN RESUME 180
+530 RESUME NEXT
+600 PRINT "second handler"; ERR; ERL : END
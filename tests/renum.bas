@@ -0,0 +1,14 @@
+10 ON ERROR GOTO 100
+20 RESTORE 140
+30 READ A : PRINT "read"; A
+40 GOSUB 120
+50 I = 2 : ON I GOTO 60, 70
+60 PRINT "wrong" : END
+70 IF A = 3 THEN 80 ELSE 60
+80 ERROR 250
+90 PRINT "resumed" : END
+100 PRINT "error"; ERR; "in"; ERL
+110 RESUME 90
+120 PRINT "gosub" : RETURN
+130 DATA 1
+140 DATA 3
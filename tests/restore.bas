@@ -0,0 +1,13 @@
+10 READ A
+20 RESTORE 110
+30 READ B
+40 RESTORE 120
+50 READ C
+60 RESTORE
+70 READ D
+80 PRINT A; B; C; D
+90 END
+100 DATA 1
+110 DATA 2
+120 REM Before the last DATA
+130 DATA 3
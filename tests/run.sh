@@ -0,0 +1,77 @@
+#!/bin/sh
+# Regression programs: each tests/<name>.bas is run in the eager, optimized (-O) and lazy (-L) load modes,
+# and its output must be tests/<name>.txt in each of them, or tests/<name>.<mode>.txt when it differs in a mode
+# (E, O or L). The output is the one of every job of the run, the outputs being taken in the order of their names.
+# tests/<name>.args holds the options given before the program, as written on a shell command line,
+# tests/<name>.next the jobs run after the program, as written on a command line too (the snapshot it saved),
+# and tests/<name>.modes the modes it runs in when not all of them ("E L" for instance).
+# tests/<name>.err (or <name>.<mode>.err) holds a text the error message of the report must contain, and
+# tests/<name>.metrics (or <name>.<mode>.metrics) the msbasic_statements_total and msbasic_operations_total lines
+# the metrics of the run must be.
+# Each run works in a fresh copy of tests/, which receives the files the program writes and is then removed.
+# Usage: tests/run.sh ms-basic
+
+BIN=$(cd "$(dirname "$1")" && pwd)/$(basename "$1")
+cd "$(dirname "$0")" || exit 1
+TESTS=$(pwd)
+OUT=$(mktemp -d)
+trap 'rm -rf "$OUT"' EXIT
+
+# Expected file of a test in a mode: the one of the mode if any, else the one of every mode, else none.
+expected() {
+	if [ -f "$1.$2.$3" ]; then echo "$1.$2.$3"
+	elif [ -f "$1.$3" ]; then echo "$1.$3"
+	fi
+}
+
+failures=0
+for program in *.bas; do
+	name=$(basename "$program" .bas)
+	modes="E O L"
+	[ -f "$name.modes" ] && modes=$(cat "$name.modes")
+	args=""
+	[ -f "$name.args" ] && args=$(cat "$name.args")
+	next=""
+	[ -f "$name.next" ] && next=$(cat "$name.next")
+
+	for mode in $modes; do
+		flag=""
+		[ "$mode" != E ] && flag="-$mode"
+		rm -rf "$OUT/work" "$OUT/output" "$OUT/metrics"
+		cp -R "$TESTS" "$OUT/work"
+		mkdir "$OUT/output"
+		(cd "$OUT/work" && eval "\"\$BIN\" $flag -o \"\$OUT/output\" -m \"\$OUT/metrics\" $args \"\$program\" $next") > "$OUT/report.json"
+		cat "$OUT/output"/*.out > "$OUT/output.txt" 2> /dev/null
+
+		failed=""
+		: > "$OUT/diff"
+		if ! cmp -s "$(expected "$name" "$mode" txt)" "$OUT/output.txt"; then
+			failed=" output"
+			diff "$(expected "$name" "$mode" txt)" "$OUT/output.txt" >> "$OUT/diff"
+		fi
+		err=$(expected "$name" "$mode" err)
+		if [ -n "$err" ] && ! grep -qF "$(cat "$err")" "$OUT/report.json"; then
+			failed="$failed error"
+		fi
+		metrics=$(expected "$name" "$mode" metrics)
+		if [ -n "$metrics" ]; then
+			grep -E '^msbasic_(statements|operations)_total' "$OUT/metrics" > "$OUT/counters.txt"
+			if ! cmp -s "$metrics" "$OUT/counters.txt"; then
+				failed="$failed metrics"
+				diff "$metrics" "$OUT/counters.txt" >> "$OUT/diff"
+			fi
+		fi
+
+		if [ -z "$failed" ]; then
+			echo "$name ($mode): ok"
+		else
+			echo "$name ($mode): FAILED,$failed"
+			cat "$OUT/diff"
+			cat "$OUT/report.json"
+			failures=$((failures + 1))
+		fi
+	done
+done
+
+[ $failures -eq 0 ] || echo "$failures failure(s)"
+[ $failures -eq 0 ]
@@ -0,0 +1,15 @@
+10 DEFINT I : DIM B$(3) : ON ERROR GOTO 500
+20 DATA 1, 2, 3, 4
+30 READ X : RANDOMIZE 5 : R = RND(1)
+40 FOR I = 1 TO 3
+50 GOSUB 200
+60 NEXT I
+70 PRINT "end"; X; Y; B$(2); INT(R * 1000); INT(RND(1) * 1000)
+80 ERROR 11
+90 PRINT "resumed"; I : END
+200 REM The snapshot is taken in the GOSUB, inside the FOR loop
+210 B$(I) = STR$(I * 2) : READ Y : PRINT "sub"; I; Y;
+220 IF I = 2 THEN STOP
+230 PRINT "back"
+240 RETURN
+500 PRINT "error"; ERR; "in"; ERL : RESUME NEXT
@@ -0,0 +1,6 @@
+10 REM Unbounded recursion runs out of control stack, trapped as Out of memory
+20 ON ERROR GOTO 100
+30 GOSUB 50
+40 PRINT "never" : END
+50 D = D + 1 : GOSUB 50
+100 PRINT "error"; ERR; "in"; ERL; "at depth"; D
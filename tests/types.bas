@@ -0,0 +1,13 @@
+10 DEFINT I-N
+20 DEFSTR S
+30 DEFDBL D
+40 ON ERROR GOTO 200
+50 I = 7 / 2 : X = 7 / 2 : PRINT I; X
+60 J = 10 : PRINT J / 4; J \ 4; J * 3.3
+70 S = "string" : PRINT S; LEN(S)
+80 D = 1 / 3 : X = 1 / 3 : PRINT D; X
+90 X = 32767 : X = X + 1 : PRINT X
+100 K = 32767 : K = K + 1 : PRINT K
+110 A% = -32768 : A% = A% - 1 : PRINT A%
+120 END
+200 PRINT "error"; ERR; "in"; ERL : RESUME NEXT
@@ -0,0 +1,27 @@
+10 REM The examples of PRINT USING in the GW-BASIC manual
+20 A$ = "LOOK" : B$ = "OUT"
+30 PRINT USING "!"; A$; B$
+40 PRINT USING "\  \"; A$; B$
+50 PRINT USING "\    \"; A$; B$; "!!"
+60 PRINT USING "!"; A$;
+70 PRINT USING "&"; B$
+80 PRINT USING "##.##"; .78
+90 PRINT USING "###.##"; 987.654
+100 PRINT USING "##.## "; 10.2, 5.3, 66.789, .234
+110 PRINT USING "+##.## "; -68.95, 2.4, 55.6, -.9
+120 PRINT USING "##.##- "; -68.95, 22.449, -7.01
+130 PRINT USING "**#.# "; 12.39, -.9, 765.1
+140 PRINT USING "$$###.##"; 456.78
+150 PRINT USING "**$##.##"; 2.34
+160 PRINT USING "####,.##"; 1234.5
+170 PRINT USING "####.##"; 1234.5
+180 PRINT USING "##.##^^^^"; 234.56
+190 PRINT USING ".####^^^^-"; -888888
+200 PRINT USING "+.##^^^^"; 123
+210 PRINT USING "_!##.##_!"; 12.34
+220 PRINT USING "##.##"; 111.22
+230 PRINT USING ".##"; .999
+240 PRINT USING "Total: ###.## Name: &"; 3, "X"
+250 F$ = "#### "
+260 FOR I = 1 TO 4 : PRINT USING F$; I * 1.5; : NEXT I : PRINT
+270 FOR I = 1 TO 3 : PRINT USING "[##.#] "; I / 3; : NEXT I : PRINT